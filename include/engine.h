@@ -0,0 +1,395 @@
+#ifndef _ENGINE_H_
+#define _ENGINE_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+/// Side length of the square tiles the board keeps population counts for
+#define TILE_SIZE 8
+
+/// Label container for our return values
+enum error_codes {
+  E_SUCCESS,
+  E_CURSES,
+  E_MOUSE,
+  E_INPUT,
+  E_OPTION,
+  E_IO,
+  E_ALLOC,
+};
+
+/// Source of the memory backing a board, `free` is given the size originally
+///  requested from `alloc`
+///  - `zeroed` allocators return zeroed memory, boards leave it untouched
+struct allocator {
+  void *(*alloc)(size_t, void *);
+  void (*free)(void *, size_t, void *);
+  void *ctx;
+  bool zeroed;
+};
+
+/// How large board buffers are backed by memory, from mappings of regular
+///  pages, transparent huge pages or explicitly reserved huge pages
+enum page_policy {
+  PAGES_NORMAL,
+  PAGES_TRANSPARENT,
+  PAGES_EXPLICIT,
+};
+
+/// Allocator mapping buffers of at least a huge page directly, so that they
+///  are huge page aligned and left untouched (zeroed) until first written
+///
+/// Explicit huge pages fall back to transparent ones when none are reserved
+struct page_allocator {
+  struct allocator alloc;
+  enum page_policy policy;
+  size_t huge_size;
+};
+
+/// Nodes counted when reporting where a buffer's pages lie
+#define REPORT_NODES 8
+
+/// The pages backing a buffer, `node_pages` counting the sampled pages on each
+///  node, `samples` is negative if placement could not be queried
+struct page_report {
+  size_t page_size;
+  size_t huge_bytes;
+  size_t size;
+  int node_pages[REPORT_NODES];
+  int samples;
+};
+
+/// Threads kept alive between steps, each always working on the same rows of
+///  the board so that those rows stay on the thread's memory node
+struct band_pool {
+  int threads;
+  pthread_t *ids;
+  pthread_mutex_t gate;
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+  pthread_barrier_t sync;
+  void (*job)(void *, int);
+  void *arg;
+};
+
+/// A life-like rule, bit `n` of `birth` being set if inactive cells with `n`
+///  neighbours become active, likewise for `survive` and active cells
+struct rule {
+  uint16_t birth;
+  uint16_t survive;
+};
+
+/// Conway's B3/S23
+#define CONWAY_RULE ((struct rule){.birth = 1 << 3, .survive = 1 << 2 | 1 << 3})
+
+/// The simulation state, one byte per cell (0 or 1) independent of the size
+///  of the terminal
+///
+/// The population of each `TILE_SIZE` square tile is kept up to date by the
+///  engine, so that summaries of the board never need to rescan its cells
+///
+/// Stepping works in `scratch`, a pair of band `windows` per thread and, when
+///  flips span several blocks, a copy of the starting generation in `origin`,
+///  all kept for the life of the board rather than allocated per step
+struct board {
+  uint8_t *cells;
+  uint8_t *scratch;
+  uint8_t *origin;
+  uint8_t *windows;
+  uint32_t *tile_pop;
+  int lines;
+  int cols;
+  int tile_lines;
+  int tile_cols;
+  bool wrapping;
+  struct rule rule;
+  long generation;
+  struct allocator alloc;
+  struct band_pool *pool;
+};
+
+/// Indices of cells which changed state, in increasing order
+struct flip_set {
+  size_t *idx;
+  size_t len;
+  size_t cap;
+};
+
+/// A single recorded state, either as the flips leading back to it from the
+///  following record or as a keyframe of the whole board
+struct history_record {
+  size_t offset;
+  size_t len;
+  long generation;
+  bool keyframe;
+};
+
+/// Bounded rewind buffer of recent board states
+///
+/// Records live back to back in a ring-buffer `pool`, the oldest records being
+///  evicted as room is needed for new ones
+struct history {
+  uint8_t *pool;
+  size_t capacity;
+  struct history_record *records;
+  int slots;
+  int first;
+  int count;
+  int since_keyframe;
+};
+
+enum halo_side {
+  HALO_TOP,
+  HALO_BOTTOM,
+};
+
+/// How a domain's processes talk to each other, keeping the domain itself
+///  independent of how commands, halos and bands actually move between them
+///
+/// The parent side
+///  - `issue` sends a command to every worker, `await_one` waits up to a
+///    timeout in milliseconds for any one of them to finish it
+///  - `push_cells` and `fetch_cells` move the board's cells to the workers
+///    before they load their bands, and back after they store them
+///  - `fetch_tiles` and `fetch_flips` collect what the workers published
+///    after a step, the flips of one worker at a time
+///  - `release` hands the board back and frees the transport
+///
+/// The worker side
+///  - `store_tiles` publishes the population of a band's tile rows
+///  - `store_flips` publishes the cells a step changed, relative to the start
+///    of the worker's band, NULL if they could not be collected
+struct halo_transport {
+  void (*issue)(struct halo_transport *, int, long);
+  bool (*await_one)(struct halo_transport *, int);
+  void (*push_cells)(struct halo_transport *);
+  void (*fetch_cells)(struct halo_transport *);
+  void (*fetch_tiles)(struct halo_transport *);
+  enum error_codes (*fetch_flips)(struct halo_transport *, int,
+                                  struct flip_set *);
+  void (*release)(struct halo_transport *);
+  int (*wait_command)(struct halo_transport *, int, long *);
+  void (*load_band)(struct halo_transport *, int, int, uint8_t *);
+  void (*store_band)(struct halo_transport *, int, int, const uint8_t *);
+  void (*store_tiles)(struct halo_transport *, int, int, const uint32_t *);
+  void (*store_flips)(struct halo_transport *, int, const struct flip_set *);
+  void (*send_halo)(struct halo_transport *, int, enum halo_side,
+                    const uint8_t *);
+  void (*recv_halo)(struct halo_transport *, int, enum halo_side, uint8_t *);
+  void (*signal_done)(struct halo_transport *, int);
+  void *state;
+};
+
+/// A board split by rows between worker processes, `bands` holding the first
+///  row of each worker's band followed by the board's line count
+///
+/// The transport may move the board's cells and tiles elsewhere while the
+///  domain lives, they are handed back by `domain_free`
+///  - `stale` cells are behind the bands held by the workers
+///  - `dirty` cells were changed since the workers last loaded them
+struct domain {
+  int workers;
+  pid_t *pids;
+  int *bands;
+  bool failed;
+  bool stale;
+  bool dirty;
+  struct board *board;
+  struct halo_transport transport;
+};
+
+/// Bytes of the header preceding every frame of a stream
+#define FRAME_HEADER_LEN 28
+
+enum frame_type {
+  FRAME_KEYFRAME = 1,
+  FRAME_DELTA = 2,
+};
+
+/// A viewer connected to a stream, `buf` holding the frame being sent to it
+///  - `stale` viewers fell behind and are sent a keyframe once they catch up
+struct stream_client {
+  int fd;
+  uint8_t *buf;
+  size_t cap;
+  size_t len;
+  size_t sent;
+  bool stale;
+};
+
+/// Server publishing frames to viewers over a Unix domain socket or a
+///  loopback TCP port
+struct stream_server {
+  int fd;
+  char path[108];
+  struct stream_client *clients;
+  int n_clients;
+  int cap_clients;
+};
+
+/// A frame partially received by a viewer
+struct stream_reader {
+  uint8_t header[FRAME_HEADER_LEN];
+  uint8_t *payload;
+  size_t cap;
+  size_t len;
+  size_t got;
+};
+
+/// Formats boards are written in, both are read back
+enum cell_format {
+  FORMAT_TEXT,   // A line of 'A' and '_' characters per row
+  FORMAT_PACKED, // A binary header then each row packed 8 cells to the byte
+};
+
+struct InfileData {
+  uint8_t *cells;
+  int lines;
+  int cols;
+};
+
+static inline int min(int a, int b) {
+  if (a < b) {
+    return a;
+  }
+  return b;
+}
+
+static inline int max(int a, int b) {
+  if (a > b) {
+    return a;
+  }
+  return b;
+}
+
+//------------------ Engine ------------------
+
+enum error_codes parse_rule(const char *, struct rule *);
+
+void step_row(const uint8_t *, const uint8_t *, const uint8_t *, uint8_t *, int,
+              bool, const struct rule *);
+
+enum error_codes board_init(struct board *, int, int, bool,
+                            const struct allocator *);
+
+void board_free(struct board *);
+
+void blit_cells(struct board *, const uint8_t *, int, int);
+
+void recount_tiles(struct board *);
+
+void count_tile_rows(const uint8_t *, uint32_t *, int, int, int);
+
+enum error_codes collect_flips(const uint8_t *, const uint8_t *,
+                               struct flip_set *, int, int, int);
+
+enum error_codes iterate(struct board *, long, struct flip_set *);
+
+enum error_codes flip_set_push(struct flip_set *, size_t);
+
+void flip_set_free(struct flip_set *);
+
+int count_neighbours(struct board *, int, int);
+
+bool cell_is_active(struct board *, int, int);
+
+uint8_t *get_cell(struct board *, int, int);
+
+int flip_by_cords(struct board *, int, int);
+
+uint64_t tile_range_pop(struct board *, int, int, int, int);
+
+enum error_codes make_backup(struct board *, struct board *);
+
+enum error_codes board_set_threads(struct board *, int);
+
+//------------------ IO ------------------
+
+enum error_codes read_cells(const char *, struct InfileData *);
+
+enum error_codes write_cells(const char *, struct board *, enum cell_format);
+
+//------------------ Domain ------------------
+
+enum error_codes domain_init(struct domain *, struct board *, int);
+
+enum error_codes domain_step(struct domain *, struct board *, long,
+                             struct flip_set *);
+
+enum error_codes domain_gather(struct domain *);
+
+void domain_scatter(struct domain *);
+
+void domain_free(struct domain *);
+
+//------------------ Pages ------------------
+
+void page_allocator_init(struct page_allocator *, enum page_policy);
+
+void page_report(const void *, size_t, struct page_report *);
+
+//------------------ Pool ------------------
+
+enum error_codes pool_init(struct band_pool *, int);
+
+void pool_run(struct band_pool *, void (*)(void *, int), void *);
+
+void pool_sync(struct band_pool *);
+
+void pool_free(struct band_pool *);
+
+//------------------ History ------------------
+
+size_t delta_len(const struct flip_set *);
+
+void encode_delta(const struct flip_set *, uint8_t *);
+
+bool decode_gap(const uint8_t **, const uint8_t *, size_t *);
+
+enum error_codes apply_delta(struct board *, const uint8_t *, size_t);
+
+void encode_keyframe(struct board *, const struct flip_set *, uint8_t *);
+
+void apply_keyframe(struct board *, const uint8_t *);
+
+enum error_codes history_init(struct history *, int);
+
+void history_free(struct history *);
+
+void history_clear(struct history *);
+
+enum error_codes history_push(struct history *, struct board *, long,
+                              const struct flip_set *);
+
+int history_rewind(struct history *, struct board *, int);
+
+//------------------ Stream ------------------
+
+enum error_codes stream_listen(struct stream_server *, const char *);
+
+void stream_accept(struct stream_server *);
+
+bool stream_wants_keyframe(const struct stream_server *);
+
+void stream_publish(struct stream_server *, struct board *,
+                    const struct flip_set *);
+
+void stream_catch_up(struct stream_server *, struct board *);
+
+void stream_flush(struct stream_server *);
+
+void stream_close(struct stream_server *);
+
+enum error_codes stream_connect(const char *, int *);
+
+enum error_codes stream_read(struct stream_reader *, int, struct board *,
+                             int *);
+
+void stream_reader_free(struct stream_reader *);
+
+#endif // _ENGINE_H_
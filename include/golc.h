@@ -5,22 +5,29 @@
 #include <locale.h>
 #include <ncurses.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 
+#include "engine.h"
+
 #define _GOLC_VERSION "1.0.3"
 
 #define OUTFILE_BUF_SIZE 512
 
-/// Label container for our return values
-enum error_codes {
-  E_SUCCESS,
-  E_CURSES,
-  E_MOUSE,
-  E_INPUT,
-  E_OPTION,
-  E_IO,
+/// How board cells are packed into terminal characters
+enum render_mode {
+  RENDER_BLOCK,   // 1x1 cells per character, using the active/inactive chars
+  RENDER_HALF,    // 1x2 cells per character, using half-block glyphs
+  RENDER_BRAILLE, // 2x4 cells per character, using braille patterns
+  RENDER_MODES,
+};
+
+static const char *const RENDER_MODE_NAMES[RENDER_MODES] = {
+    "block",
+    "half",
+    "braille",
 };
 
 struct parsed_args {
@@ -31,10 +38,27 @@ struct parsed_args {
   char *infile;
   wchar_t active;
   wchar_t inactive;
+  enum render_mode render_mode;
+  int zoom;
+  int view_y;
+  int view_x;
+  int board_lines;
+  int board_cols;
+  int history_mb;
+  struct rule rule;
+  int processes;
+  int threads;
+  enum page_policy pages;
+  char *serve;
+  long interval_ms;
+  long steps;
+  enum cell_format format;
 };
 
 //------------------ CLI ------------------
 
+void set_defaults(struct parsed_args *);
+
 enum error_codes parse_args(int, char **, struct parsed_args *);
 
 // TODO: These two
@@ -44,44 +68,30 @@ void show_version();
 
 //------------------ Util ------------------
 
-struct InfileData {
-  wchar_t *scr;
-  int lines;
-  int cols;
-};
-
 enum error_codes read_scr_from_file(struct parsed_args *, struct InfileData *);
 
-enum error_codes write_scr_to_file(struct parsed_args *, wchar_t *, int, int);
+enum error_codes write_scr_to_file(struct parsed_args *, struct board *);
 
 bool nstrcmp(char *, int, ...);
 
 float diff_ms(struct timeval, struct timeval);
 
-int min(int, int);
-
 //------------------ Screen ------------------
 
 enum error_codes init_screen();
 
-wchar_t *resize(wchar_t *, struct parsed_args *, int, int);
-
-void iterate(wchar_t *, struct parsed_args *);
-
-int count_neighbours(wchar_t *, struct parsed_args *, int, int);
+void render_density(enum render_mode, int *, int *);
 
-void draw_full_scr(const wchar_t *);
+void draw_full_scr(struct board *, struct parsed_args *);
 
-void draw_msg_buf(char *);
-
-bool cell_is_active(wchar_t *, struct parsed_args *);
+void draw_char(struct board *, struct parsed_args *, int, int);
 
-int flip_by_cell(wchar_t *, struct parsed_args *);
+void view_cells(struct parsed_args *, int *, int *);
 
-wchar_t *get_cell(wchar_t *, int, int);
+void pan_view(struct board *, struct parsed_args *, int, int);
 
-int flip_by_cords(wchar_t *, struct parsed_args *, int, int);
+void draw_msg_buf(char *);
 
-void make_backup(wchar_t **, wchar_t *);
+bool view_key(struct board *, struct parsed_args *, int, char *, size_t);
 
 #endif // _SCREEN_H_
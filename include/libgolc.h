@@ -0,0 +1,87 @@
+#ifndef _LIBGOLC_H_
+#define _LIBGOLC_H_
+
+/// libgolc - the golc engine without the terminal
+///
+/// Boards are opaque handles created with `golc_create` or `golc_load` and
+///  released with `golc_destroy`. Cells are exchanged in bulk as one byte per
+///  cell, 0 being inactive and anything else active.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GOLC_API __attribute__((visibility("default")))
+
+typedef struct golc_board golc_board;
+
+typedef enum {
+  GOLC_OK,
+  GOLC_EINVAL, // Invalid argument, e.g. a malformed rule or out-of-bounds rect
+  GOLC_ENOMEM, // An allocation failed
+  GOLC_EIO,    // A file could not be read or written
+} golc_status;
+
+/// Memory source for everything a board allocates, `free` is given the size
+///  originally requested from `alloc`
+typedef struct {
+  void *(*alloc)(size_t size, void *ctx);
+  void (*free)(void *ptr, size_t size, void *ctx);
+  void *ctx;
+} golc_allocator;
+
+/// A rectangle of cells, `y` and `x` being the top-left cell
+typedef struct {
+  int y;
+  int x;
+  int lines;
+  int cols;
+} golc_rect;
+
+/// Create an inactive board
+///  - `rule` is in B/S notation, e.g. "B3/S23", NULL for Conway's rule
+///  - `alloc` may be NULL to use `malloc`
+GOLC_API golc_status golc_create(golc_board **board, int lines, int cols,
+                                 const char *rule, bool wrapping,
+                                 const golc_allocator *alloc);
+
+/// Create a board from a file written by `golc_save` or `golc`, in either of
+///  golc's formats, taking the dimensions of its contents
+GOLC_API golc_status golc_load(golc_board **board, const char *path,
+                               const char *rule, bool wrapping,
+                               const golc_allocator *alloc);
+
+GOLC_API void golc_destroy(golc_board *board);
+
+GOLC_API golc_status golc_save(golc_board *board, const char *path);
+
+/// Advance the board by `n` generations
+GOLC_API golc_status golc_step(golc_board *board, long n);
+
+GOLC_API long golc_generation(const golc_board *board);
+
+GOLC_API void golc_dimensions(const golc_board *board, int *lines, int *cols);
+
+GOLC_API uint64_t golc_population(const golc_board *board);
+
+/// The smallest rectangle containing every active cell, false if there are
+///  none
+GOLC_API bool golc_bounding_box(const golc_board *board, golc_rect *rect);
+
+/// Copy the cells of `rect` into `out`, rows being `stride` bytes apart
+GOLC_API golc_status golc_get_rect(const golc_board *board, golc_rect rect,
+                                   uint8_t *out, size_t stride);
+
+/// Set the cells of `rect` from `in`, rows being `stride` bytes apart
+GOLC_API golc_status golc_set_rect(golc_board *board, golc_rect rect,
+                                   const uint8_t *in, size_t stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LIBGOLC_H_
@@ -10,6 +10,11 @@ void show_help() {
           "golc - Conway's Game of Life in C\n"
           "\n"
           "    golc [-w] [-o <file>] [-i <file>] [--active A] [--inactive _]\n"
+          "         [--render block|half|braille] [--size <lines>x<cols>]\n"
+          "         [--history <MB>] [--rule B3/S23] [-p <processes>]\n"
+          "         [-t <threads>] [--pages normal|transparent|explicit]\n"
+          "         [--serve <socket>|<port>] [--interval <ms>] [--steps <n>]\n"
+          "         [--format text|packed]\n"
           "\n"
           "-h|--help)     Show this help message\n"
           "-v|--version)  Print version information\n"
@@ -17,7 +22,23 @@ void show_help() {
           "-o|--outfile)  File to the which the screen may be written\n"
           "-i|--infile)   File to the which the screen may be read\n"
           "--active|--active-char)      Active cell character (ascii)\n"
-          "--inactive|--inactive-char)  Inactive cell character (ascii)\n");
+          "--inactive|--inactive-char)  Inactive cell character (ascii)\n"
+          "--render)      Cells per character, block (1x1), half (1x2) or\n"
+          "               braille (2x4)\n"
+          "--size)        Board dimensions, defaults to those of the infile\n"
+          "               or the initial terminal size\n"
+          "--history)     Memory for rewinding generations in MB, 0 disables\n"
+          "--rule)        Birth and survival neighbour counts, e.g. B36/S23\n"
+          "-p|--processes) Worker processes to split the board between\n"
+          "-t|--threads)  Threads stepping the board, each on its own rows\n"
+          "--pages)       Pages backing the board, normal, transparent huge\n"
+          "               pages or explicit (reserved) huge pages\n"
+          "--serve)       Run without a terminal, publishing frames on a Unix\n"
+          "               socket path or a loopback TCP port for golc-view\n"
+          "--interval)    Milliseconds between frames when running\n"
+          "--steps)       Generations computed per frame\n"
+          "--format)      Format of the outfile, text or packed (binary), the\n"
+          "               infile may be either\n");
 }
 
 void show_version() { fprintf(stderr, "%s\n", _GOLC_VERSION); }
@@ -30,6 +51,21 @@ void set_defaults(struct parsed_args *args) {
   args->infile = NULL;
   args->active = u'▓';
   args->inactive = u' ';
+  args->render_mode = RENDER_BLOCK;
+  args->zoom = 0;
+  args->view_y = 0;
+  args->view_x = 0;
+  args->board_lines = 0;
+  args->board_cols = 0;
+  args->history_mb = 64;
+  args->rule = CONWAY_RULE;
+  args->processes = 1;
+  args->threads = 1;
+  args->pages = PAGES_TRANSPARENT;
+  args->serve = NULL;
+  args->interval_ms = 200;
+  args->steps = 1;
+  args->format = FORMAT_TEXT;
   // For testing simple chars
   // args->active = u'A';
   // args->inactive = u'I';
@@ -57,18 +93,24 @@ enum error_codes parse_args(int argc, char **argv, struct parsed_args *args) {
       } else if (nstrcmp(opt, 2, "-o", "--outfile")) {
         if (++i == argc) {
           fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
         }
         strncpy(args->outfile, argv[i], OUTFILE_BUF_SIZE);
 
       } else if (nstrcmp(opt, 2, "-i", "--infile")) {
         if (++i == argc) {
           fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
         }
         args->infile = argv[i];
 
       } else if (nstrcmp(opt, 2, "--active", "--active-char")) {
         if (++i == argc) {
           fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
         }
         // Note:
         //
@@ -111,10 +153,151 @@ enum error_codes parse_args(int argc, char **argv, struct parsed_args *args) {
       } else if (nstrcmp(opt, 2, "--inactive", "--inactive-char")) {
         if (++i == argc) {
           fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
         }
         // See above...
         args->inactive = argv[i][0];
 
+      } else if (nstrcmp(opt, 1, "--render")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (nstrcmp(argv[i], 1, "block")) {
+          args->render_mode = RENDER_BLOCK;
+        } else if (nstrcmp(argv[i], 1, "half")) {
+          args->render_mode = RENDER_HALF;
+        } else if (nstrcmp(argv[i], 1, "braille")) {
+          args->render_mode = RENDER_BRAILLE;
+        } else {
+          fprintf(stderr, "Unknown render mode (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 1, "--size")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (sscanf(argv[i], "%dx%d", &args->board_lines, &args->board_cols) !=
+                2 ||
+            args->board_lines <= 0 || args->board_cols <= 0) {
+          fprintf(stderr, "Invalid board size (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 1, "--history")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (sscanf(argv[i], "%d", &args->history_mb) != 1 ||
+            args->history_mb < 0) {
+          fprintf(stderr, "Invalid history size (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 1, "--rule")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (parse_rule(argv[i], &args->rule) != E_SUCCESS) {
+          fprintf(stderr, "Invalid rule (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 2, "-p", "--processes")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (sscanf(argv[i], "%d", &args->processes) != 1 ||
+            args->processes < 1) {
+          fprintf(stderr, "Invalid process count (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 2, "-t", "--threads")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (sscanf(argv[i], "%d", &args->threads) != 1 || args->threads < 1) {
+          fprintf(stderr, "Invalid thread count (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 1, "--pages")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (nstrcmp(argv[i], 1, "normal")) {
+          args->pages = PAGES_NORMAL;
+        } else if (nstrcmp(argv[i], 1, "transparent")) {
+          args->pages = PAGES_TRANSPARENT;
+        } else if (nstrcmp(argv[i], 1, "explicit")) {
+          args->pages = PAGES_EXPLICIT;
+        } else {
+          fprintf(stderr, "Unknown page policy (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 1, "--serve")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        args->serve = argv[i];
+
+      } else if (nstrcmp(opt, 1, "--interval")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (sscanf(argv[i], "%ld", &args->interval_ms) != 1 ||
+            args->interval_ms < 0) {
+          fprintf(stderr, "Invalid interval (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 1, "--steps")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (sscanf(argv[i], "%ld", &args->steps) != 1 || args->steps < 1) {
+          fprintf(stderr, "Invalid steps per frame (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
+      } else if (nstrcmp(opt, 1, "--format")) {
+        if (++i == argc) {
+          fprintf(stderr, "[CLI] Option (%s) has no string", opt);
+          ec = E_OPTION;
+          break;
+        }
+        if (nstrcmp(argv[i], 1, "text")) {
+          args->format = FORMAT_TEXT;
+        } else if (nstrcmp(argv[i], 1, "packed")) {
+          args->format = FORMAT_PACKED;
+        } else {
+          fprintf(stderr, "Unknown format (%s)", argv[i]);
+          ec = E_OPTION;
+        }
+
       } else {
         fprintf(stderr, "Unknown option (%s)", opt);
         ec = E_OPTION;
@@ -0,0 +1,618 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "engine.h"
+
+/// How long the parent waits on its workers before checking none have died
+#define WORKER_POLL_MS 100
+
+enum domain_command {
+  CMD_LOAD,
+  CMD_STORE,
+  CMD_STEP,
+  CMD_STEP_FLIPS,
+  CMD_EXIT,
+};
+
+/// Control block at the start of the shared segment
+struct domain_ctl {
+  enum domain_command command;
+  long steps;
+  sem_t done;
+};
+
+/// A single halo row published by one worker for one neighbour, guarded by a
+///  pair of semaphores so that it is only overwritten once it has been read
+struct halo_slot {
+  sem_t empty;
+  sem_t full;
+};
+
+/// The flips of a worker's last step, `len` bytes of its flip area holding
+///  either LEB128 gaps as in the history or, when those would not fit, a
+///  bitmap of its band
+///  - `lost` flips could not be collected by the worker
+struct flip_report {
+  size_t len;
+  bool bitmap;
+  bool lost;
+};
+
+/// Pointers into the shared segment, mapped before forking so that they are
+///  valid in every worker
+///  - `bands` holds the first row of each worker's band, followed by the
+///    board's line count
+///  - `flip_offsets` locates each worker's area of `flip_data`, large enough
+///    for a bitmap of its band
+///  - The board's own buffers are set aside in `board_cells` and `board_tiles`
+///    while it uses those of the segment
+struct shm_state {
+  uint8_t *seg;
+  size_t size;
+  struct domain_ctl *ctl;
+  sem_t *start;
+  struct halo_slot *slots;
+  struct flip_report *reports;
+  uint32_t *tiles;
+  uint8_t *rows;
+  uint8_t *cells;
+  uint8_t *flip_data;
+  const int *bands;
+  size_t *flip_offsets;
+  int workers;
+  int cols;
+  int tile_cols;
+  struct board *board;
+  uint8_t *board_cells;
+  uint32_t *board_tiles;
+};
+
+static struct halo_slot *shm_slot(struct shm_state *shm, int worker,
+                                  enum halo_side side) {
+  return shm->slots + (worker * 2) + side;
+}
+
+static uint8_t *shm_row(struct shm_state *shm, int worker,
+                        enum halo_side side) {
+  return shm->rows + ((size_t)((worker * 2) + side) * shm->cols);
+}
+
+/// Bytes in a bitmap of worker `w`'s band
+static size_t band_bitmap_len(struct shm_state *shm, int w) {
+  return (((size_t)(shm->bands[w + 1] - shm->bands[w]) * shm->cols) + 7) / 8;
+}
+
+static int shm_wait_command(struct halo_transport *t, int worker,
+                            long *steps) {
+  struct shm_state *shm = t->state;
+  while (sem_wait(shm->start + worker) == -1 && errno == EINTR) {
+  }
+  *steps = shm->ctl->steps;
+  return shm->ctl->command;
+}
+
+static void shm_load_band(struct halo_transport *t, int r0, int r1,
+                          uint8_t *dst) {
+  struct shm_state *shm = t->state;
+  memcpy(dst, shm->cells + ((size_t)r0 * shm->cols),
+         (size_t)(r1 - r0) * shm->cols);
+}
+
+static void shm_store_band(struct halo_transport *t, int r0, int r1,
+                           const uint8_t *src) {
+  struct shm_state *shm = t->state;
+  memcpy(shm->cells + ((size_t)r0 * shm->cols), src,
+         (size_t)(r1 - r0) * shm->cols);
+}
+
+static void shm_store_tiles(struct halo_transport *t, int t0, int t1,
+                            const uint32_t *tiles) {
+  struct shm_state *shm = t->state;
+  memcpy(shm->tiles + ((size_t)t0 * shm->tile_cols), tiles,
+         (size_t)(t1 - t0) * shm->tile_cols * sizeof(uint32_t));
+}
+
+static void shm_store_flips(struct halo_transport *t, int worker,
+                            const struct flip_set *flips) {
+  struct shm_state *shm = t->state;
+  struct flip_report *report = shm->reports + worker;
+  uint8_t *data = shm->flip_data + shm->flip_offsets[worker];
+  size_t bitmap_len = band_bitmap_len(shm, worker);
+  report->lost = !flips;
+  if (!flips) {
+    return;
+  }
+  report->len = delta_len(flips);
+  report->bitmap = report->len >= bitmap_len;
+  if (report->bitmap) {
+    report->len = bitmap_len;
+    memset(data, 0, bitmap_len);
+    for (size_t i = 0; i < flips->len; i++) {
+      data[flips->idx[i] / 8] |= 1 << (flips->idx[i] % 8);
+    }
+  } else {
+    encode_delta(flips, data);
+  }
+}
+
+static void shm_send_halo(struct halo_transport *t, int worker,
+                          enum halo_side side, const uint8_t *row) {
+  struct shm_state *shm = t->state;
+  struct halo_slot *slot = shm_slot(shm, worker, side);
+  while (sem_wait(&slot->empty) == -1 && errno == EINTR) {
+  }
+  memcpy(shm_row(shm, worker, side), row, shm->cols);
+  sem_post(&slot->full);
+}
+
+static void shm_recv_halo(struct halo_transport *t, int worker,
+                          enum halo_side side, uint8_t *row) {
+  struct shm_state *shm = t->state;
+  struct halo_slot *slot = shm_slot(shm, worker, side);
+  while (sem_wait(&slot->full) == -1 && errno == EINTR) {
+  }
+  memcpy(row, shm_row(shm, worker, side), shm->cols);
+  sem_post(&slot->empty);
+}
+
+static void shm_signal_done(struct halo_transport *t, int worker) {
+  (void)worker;
+  struct shm_state *shm = t->state;
+  sem_post(&shm->ctl->done);
+}
+
+static void shm_issue(struct halo_transport *t, int command, long steps) {
+  struct shm_state *shm = t->state;
+  shm->ctl->command = command;
+  shm->ctl->steps = steps;
+  for (int w = 0; w < shm->workers; w++) {
+    sem_post(shm->start + w);
+  }
+}
+
+static bool shm_await_one(struct halo_transport *t, int timeout_ms) {
+  struct shm_state *shm = t->state;
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_nsec += timeout_ms * 1000000L;
+  ts.tv_sec += ts.tv_nsec / 1000000000L;
+  ts.tv_nsec %= 1000000000L;
+  return sem_timedwait(&shm->ctl->done, &ts) == 0;
+}
+
+/// The board's cells and tiles are those of the segment, written in place by
+///  the workers, so there is nothing to move between them and the board
+static void shm_sync_board(struct halo_transport *t) { (void)t; }
+
+/// Append the flips reported by worker `w` to `flips`, as indices into the
+///  whole board
+static enum error_codes shm_fetch_flips(struct halo_transport *t, int w,
+                                        struct flip_set *flips) {
+  struct shm_state *shm = t->state;
+  const struct flip_report *report = shm->reports + w;
+  const uint8_t *data = shm->flip_data + shm->flip_offsets[w];
+  size_t base = (size_t)shm->bands[w] * shm->cols;
+  if (report->lost) {
+    return E_ALLOC;
+  }
+  if (report->bitmap) {
+    for (size_t i = 0; i < report->len; i++) {
+      for (int bit = 0; data[i] >> bit; bit++) {
+        if ((data[i] >> bit) & 1 &&
+            flip_set_push(flips, base + (i * 8) + bit) != E_SUCCESS) {
+          return E_ALLOC;
+        }
+      }
+    }
+    return E_SUCCESS;
+  }
+  size_t idx = base, gap;
+  for (const uint8_t *in = data, *end = data + report->len; in < end;) {
+    decode_gap(&in, end, &gap);
+    idx += gap;
+    if (flip_set_push(flips, idx) != E_SUCCESS) {
+      return E_ALLOC;
+    }
+  }
+  return E_SUCCESS;
+}
+
+/// Hand the board back its own buffers, holding the segment's cells and
+///  tiles, and unmap the segment
+static void shm_release(struct halo_transport *t) {
+  struct shm_state *shm = t->state;
+  struct board *board = shm->board;
+  if (board) {
+    memcpy(shm->board_cells, shm->cells, (size_t)board->lines * shm->cols);
+    memcpy(shm->board_tiles, shm->tiles,
+           (size_t)board->tile_lines * shm->tile_cols * sizeof(uint32_t));
+    board->cells = shm->board_cells;
+    board->tile_pop = shm->board_tiles;
+  }
+  munmap(shm->seg, shm->size);
+  free(shm->flip_offsets);
+  free(shm);
+  t->state = NULL;
+}
+
+/// Set up a transport over a POSIX shared memory segment for the `workers`
+///  bands starting at the rows in `bands`, to be called before forking
+///
+/// The board's cells and tiles are moved into the segment until the transport
+///  is released. The segment is unlinked as soon as it is mapped, it lives
+///  only as long as the processes holding it
+static enum error_codes shm_transport_init(struct halo_transport *t,
+                                           struct board *board, int workers,
+                                           const int *bands) {
+  int cols = board->cols;
+  size_t n_cells = (size_t)board->lines * cols;
+
+  struct shm_state *shm = calloc(1, sizeof(struct shm_state));
+  size_t *flip_offsets = malloc(workers * sizeof(size_t));
+  if (!shm || !flip_offsets) {
+    free(shm);
+    free(flip_offsets);
+    return E_ALLOC;
+  }
+  size_t flips_size = 0;
+  for (int w = 0; w < workers; w++) {
+    flip_offsets[w] = flips_size;
+    flips_size += (((size_t)(bands[w + 1] - bands[w]) * cols) + 7) / 8;
+  }
+
+  // Word-sized parts come first, keeping them aligned
+  size_t ctl_size = sizeof(struct domain_ctl);
+  size_t start_size = workers * sizeof(sem_t);
+  size_t slots_size = workers * 2 * sizeof(struct halo_slot);
+  size_t reports_size = workers * sizeof(struct flip_report);
+  size_t tiles_size =
+      (size_t)board->tile_lines * board->tile_cols * sizeof(uint32_t);
+  size_t rows_size = (size_t)workers * 2 * cols;
+  shm->size = ctl_size + start_size + slots_size + reports_size + tiles_size +
+              rows_size + n_cells + flips_size;
+
+  char name[64];
+  snprintf(name, sizeof(name), "/golc.%d", getpid());
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd != -1) {
+    shm_unlink(name);
+    if (ftruncate(fd, shm->size) == 0) {
+      shm->seg = mmap(NULL, shm->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                      0);
+    }
+    close(fd);
+  }
+  if (!shm->seg || shm->seg == MAP_FAILED) {
+    free(shm);
+    free(flip_offsets);
+    return E_IO;
+  }
+
+  uint8_t *seg = shm->seg;
+  shm->ctl = (struct domain_ctl *)seg;
+  shm->start = (sem_t *)(seg + ctl_size);
+  shm->slots = (struct halo_slot *)(seg + ctl_size + start_size);
+  shm->reports =
+      (struct flip_report *)(seg + ctl_size + start_size + slots_size);
+  shm->tiles = (uint32_t *)((uint8_t *)shm->reports + reports_size);
+  shm->rows = (uint8_t *)shm->tiles + tiles_size;
+  shm->cells = shm->rows + rows_size;
+  shm->flip_data = shm->cells + n_cells;
+  shm->bands = bands;
+  shm->flip_offsets = flip_offsets;
+  shm->workers = workers;
+  shm->cols = cols;
+  shm->tile_cols = board->tile_cols;
+
+  sem_init(&shm->ctl->done, 1, 0);
+  for (int w = 0; w < workers; w++) {
+    sem_init(shm->start + w, 1, 0);
+    for (int side = HALO_TOP; side <= HALO_BOTTOM; side++) {
+      sem_init(&shm_slot(shm, w, side)->empty, 1, 1);
+      sem_init(&shm_slot(shm, w, side)->full, 1, 0);
+    }
+  }
+
+  memcpy(shm->cells, board->cells, n_cells);
+  memcpy(shm->tiles, board->tile_pop, tiles_size);
+  shm->board = board;
+  shm->board_cells = board->cells;
+  shm->board_tiles = board->tile_pop;
+  board->cells = shm->cells;
+  board->tile_pop = shm->tiles;
+
+  *t = (struct halo_transport){
+      .issue = shm_issue,
+      .await_one = shm_await_one,
+      .push_cells = shm_sync_board,
+      .fetch_cells = shm_sync_board,
+      .fetch_tiles = shm_sync_board,
+      .fetch_flips = shm_fetch_flips,
+      .release = shm_release,
+      .wait_command = shm_wait_command,
+      .load_band = shm_load_band,
+      .store_band = shm_store_band,
+      .store_tiles = shm_store_tiles,
+      .store_flips = shm_store_flips,
+      .send_halo = shm_send_halo,
+      .recv_halo = shm_recv_halo,
+      .signal_done = shm_signal_done,
+      .state = shm,
+  };
+  return E_SUCCESS;
+}
+
+/// Worker process body, owning rows `[r0, r1)` of the board between the ghost
+///  rows of its neighbours
+///
+/// The band stays with the worker between commands, it is only loaded from
+///  the shared cells when the parent has changed them and only stored back
+///  when the parent needs them. After each step the worker publishes the
+///  population of its tiles and, when asked to, the cells which changed
+///
+/// Each generation the worker's outermost rows are published to the
+///  neighbours above and below it, and their outermost rows received into its
+///  ghost rows, before stepping its band. At the edges of a non-wrapping board
+///  there is no neighbour, the ghost row is treated as inactive
+static void worker_loop(struct halo_transport *t, int worker, int workers,
+                        struct board *board, int r0, int r1) {
+  int cols = board->cols, n = r1 - r0;
+  bool has_up = board->wrapping || worker > 0;
+  bool has_down = board->wrapping || worker + 1 < workers;
+  int up = (worker + workers - 1) % workers, down = (worker + 1) % workers;
+  // Bands start on a tile row, so the band's tile rows are its own
+  int t0 = r0 / TILE_SIZE, t1 = (r1 + TILE_SIZE - 1) / TILE_SIZE;
+
+  // Rows 0 and n + 1 are ghost rows, rows 1 to n are owned
+  size_t band_size = (size_t)(n + 2) * cols;
+  uint8_t *buf[2] = {malloc(band_size), malloc(band_size)};
+  uint8_t *origin = malloc((size_t)n * cols);
+  uint32_t *tiles =
+      malloc((size_t)(t1 - t0) * board->tile_cols * sizeof(uint32_t));
+  struct flip_set flips = {.idx = NULL};
+  if (!buf[0] || !buf[1] || !origin || !tiles) {
+    _exit(E_ALLOC);
+  }
+
+  int cur = 0;
+  t->load_band(t, r0, r1, buf[cur] + cols);
+
+  int command;
+  long steps;
+  while ((command = t->wait_command(t, worker, &steps)) != CMD_EXIT) {
+    switch (command) {
+    case CMD_LOAD:
+      t->load_band(t, r0, r1, buf[cur] + cols);
+      break;
+
+    case CMD_STORE:
+      t->store_band(t, r0, r1, buf[cur] + cols);
+      break;
+
+    case CMD_STEP:
+    case CMD_STEP_FLIPS:
+      if (command == CMD_STEP_FLIPS) {
+        memcpy(origin, buf[cur] + cols, (size_t)n * cols);
+      }
+      for (long g = 0; g < steps; g++) {
+        uint8_t *in = buf[cur], *out = buf[!cur];
+        if (has_up) {
+          t->send_halo(t, worker, HALO_TOP, in + cols);
+        }
+        if (has_down) {
+          t->send_halo(t, worker, HALO_BOTTOM, in + ((size_t)n * cols));
+        }
+        if (has_up) {
+          t->recv_halo(t, up, HALO_BOTTOM, in);
+        }
+        if (has_down) {
+          t->recv_halo(t, down, HALO_TOP, in + ((size_t)(n + 1) * cols));
+        }
+        for (int i = 1; i <= n; i++) {
+          const uint8_t *above =
+              i > 1 || has_up ? in + ((size_t)(i - 1) * cols) : NULL;
+          const uint8_t *below =
+              i < n || has_down ? in + ((size_t)(i + 1) * cols) : NULL;
+          step_row(above, in + ((size_t)i * cols), below,
+                   out + ((size_t)i * cols), cols, board->wrapping,
+                   &board->rule);
+        }
+        cur = !cur;
+      }
+      count_tile_rows(buf[cur] + cols, tiles, cols, 0, n);
+      t->store_tiles(t, t0, t1, tiles);
+      if (command == CMD_STEP_FLIPS) {
+        flips.len = 0;
+        enum error_codes ec =
+            collect_flips(origin, buf[cur] + cols, &flips, cols, 0, n);
+        t->store_flips(t, worker, ec == E_SUCCESS ? &flips : NULL);
+      }
+      break;
+    }
+    t->signal_done(t, worker);
+  }
+
+  _exit(E_SUCCESS);
+}
+
+/// Split the board's rows between `workers` processes, each exchanging halo
+///  rows with its neighbours through a POSIX shared memory segment
+///
+/// Bands start on tile rows, so that each worker counts its own tiles, which
+///  limits the workers to one per tile row
+enum error_codes domain_init(struct domain *domain, struct board *board,
+                             int workers) {
+  memset(domain, 0, sizeof(struct domain));
+  if (workers < 2 || workers > board->tile_lines) {
+    return E_OPTION;
+  }
+  domain->bands = malloc((workers + 1) * sizeof(int));
+  domain->pids = calloc(workers, sizeof(pid_t));
+  if (!domain->bands || !domain->pids) {
+    domain_free(domain);
+    return E_ALLOC;
+  }
+  for (int w = 0; w < workers; w++) {
+    domain->bands[w] =
+        (int)(((long)w * board->tile_lines) / workers) * TILE_SIZE;
+  }
+  domain->bands[workers] = board->lines;
+
+  enum error_codes ec =
+      shm_transport_init(&domain->transport, board, workers, domain->bands);
+  if (ec != E_SUCCESS) {
+    domain_free(domain);
+    return ec;
+  }
+  domain->workers = workers;
+
+  for (int w = 0; w < workers; w++) {
+    pid_t pid = fork();
+    if (pid == -1) {
+      domain_free(domain);
+      return E_IO;
+    }
+    if (pid == 0) {
+      worker_loop(&domain->transport, w, workers, board, domain->bands[w],
+                  domain->bands[w + 1]);
+    }
+    domain->pids[w] = pid;
+  }
+
+  // Only once every worker runs, can the board be gathered from them
+  domain->board = board;
+  return E_SUCCESS;
+}
+
+/// Wait for every worker to finish its command, failing the domain if any has
+///  died
+///
+/// A reaped worker's pid is set to -1, never 0 which would have `waitpid`
+///  poll the whole process group instead
+static enum error_codes await_workers(struct domain *domain) {
+  struct halo_transport *t = &domain->transport;
+  for (int done = 0; done < domain->workers;) {
+    if (t->await_one(t, WORKER_POLL_MS)) {
+      done++;
+      continue;
+    }
+    for (int w = 0; w < domain->workers; w++) {
+      if (domain->pids[w] > 0 &&
+          waitpid(domain->pids[w], NULL, WNOHANG) != 0) {
+        domain->pids[w] = -1;
+        domain->failed = true;
+        return E_IO;
+      }
+    }
+  }
+  return E_SUCCESS;
+}
+
+/// Have every worker carry out `command` and wait for them all to finish
+static enum error_codes run_command(struct domain *domain,
+                                    enum domain_command command, long steps) {
+  if (domain->failed) {
+    return E_IO;
+  }
+  domain->transport.issue(&domain->transport, command, steps);
+  return await_workers(domain);
+}
+
+/// Iterate the board `steps` times across the domain's workers, the result is
+///  identical to that of `iterate` once gathered
+///
+/// The board's tiles are up to date on return, its cells only after
+///  `domain_gather`. Once a worker has died the domain can no longer step, its
+///  band is lost
+enum error_codes domain_step(struct domain *domain, struct board *board,
+                             long steps, struct flip_set *flips) {
+  struct halo_transport *t = &domain->transport;
+  if (flips) {
+    flips->len = 0;
+  }
+  if (domain->failed) {
+    return E_IO;
+  }
+  enum error_codes ec;
+  if (domain->dirty) {
+    t->push_cells(t);
+    ec = run_command(domain, CMD_LOAD, 0);
+    if (ec != E_SUCCESS) {
+      return ec;
+    }
+    domain->dirty = false;
+  }
+  ec = run_command(domain, flips ? CMD_STEP_FLIPS : CMD_STEP, steps);
+  if (ec != E_SUCCESS) {
+    return ec;
+  }
+  board->generation += steps;
+  domain->stale = true;
+  t->fetch_tiles(t);
+
+  // Bands are in order, so are their flips
+  for (int w = 0; flips && w < domain->workers && ec == E_SUCCESS; w++) {
+    ec = t->fetch_flips(t, w, flips);
+  }
+  return ec;
+}
+
+/// Bring the board's cells up to date with the workers' bands, for drawing or
+///  writing the board
+enum error_codes domain_gather(struct domain *domain) {
+  if (!domain->stale) {
+    return E_SUCCESS;
+  }
+  enum error_codes ec = run_command(domain, CMD_STORE, 0);
+  if (ec == E_SUCCESS) {
+    domain->transport.fetch_cells(&domain->transport);
+    domain->stale = false;
+  }
+  return ec;
+}
+
+/// Mark the board's cells as changed outside the workers, e.g. by editing or
+///  rewinding a gathered board, so that the workers reload their bands before
+///  the next step
+void domain_scatter(struct domain *domain) { domain->dirty = true; }
+
+/// Stop the workers and release the transport, a failed domain's workers are
+///  killed rather than asked to exit
+///
+/// The board is left holding the last generation gathered
+void domain_free(struct domain *domain) {
+  struct halo_transport *t = &domain->transport;
+  if (domain->board) {
+    domain_gather(domain);
+  }
+  if (t->state) {
+    t->issue(t, CMD_EXIT, 0);
+  }
+  for (int w = 0; domain->pids && w < domain->workers; w++) {
+    if (domain->pids[w] > 0) {
+      // Survivors of a failed domain may be stuck waiting on a halo which
+      //  will never arrive
+      if (domain->failed) {
+        kill(domain->pids[w], SIGKILL);
+      }
+      waitpid(domain->pids[w], NULL, 0);
+    }
+  }
+  if (t->state) {
+    t->release(t);
+  }
+  // Surviving workers may have counted tiles for a step never gathered
+  if (domain->board && domain->failed) {
+    recount_tiles(domain->board);
+  }
+  free(domain->pids);
+  free(domain->bands);
+  memset(domain, 0, sizeof(struct domain));
+}
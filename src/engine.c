@@ -0,0 +1,575 @@
+#include <ctype.h>
+#include <unistd.h>
+
+#include "engine.h"
+
+/// Rows making up a single temporally blocked band
+#define BAND_ROWS 64
+
+/// Maximum number of generations advanced within a band before moving on
+#define BLOCK_GENS 8
+
+static void *default_alloc(size_t size, void *ctx) {
+  (void)ctx;
+  return malloc(size);
+}
+
+static void default_free(void *ptr, size_t size, void *ctx) {
+  (void)size, (void)ctx;
+  free(ptr);
+}
+
+static const struct allocator DEFAULT_ALLOCATOR = {
+    .alloc = default_alloc,
+    .free = default_free,
+    .ctx = NULL,
+};
+
+static void *board_alloc(struct board *board, size_t size) {
+  return board->alloc.alloc(size, board->alloc.ctx);
+}
+
+static void board_release(struct board *board, void *ptr, size_t size) {
+  if (ptr) {
+    board->alloc.free(ptr, size, board->alloc.ctx);
+  }
+}
+
+/// Bytes of the board's step windows, a pair of bands grown by their halo
+///  rows for each thread
+static size_t windows_size(const struct board *board) {
+  int threads = board->pool ? board->pool->threads : 1;
+  size_t win_rows = BAND_ROWS + (2 * BLOCK_GENS);
+  return 2 * win_rows * board->cols * threads;
+}
+
+/// Parse a rule in B/S notation, e.g. "B3/S23" for Conway's game of life
+enum error_codes parse_rule(const char *str, struct rule *rule) {
+  struct rule parsed = {0, 0};
+  uint16_t *mask = NULL;
+  for (const char *c = str; *c; c++) {
+    if (toupper(*c) == 'B') {
+      mask = &parsed.birth;
+    } else if (toupper(*c) == 'S') {
+      mask = &parsed.survive;
+    } else if (*c >= '0' && *c <= '8' && mask) {
+      *mask |= 1 << (*c - '0');
+    } else if (*c != '/') {
+      return E_OPTION;
+    }
+  }
+  if (!mask) {
+    return E_OPTION;
+  }
+  *rule = parsed;
+  return E_SUCCESS;
+}
+
+/// Calculate the next state of a single row given the rows above and below it
+///  - `up` and `down` may be NULL, in which case they are considered inactive
+///  - Cells are born or survive by the neighbour counts set in `rule`
+void step_row(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+              uint8_t *out, int cols, bool wrapping, const struct rule *rule) {
+  const uint16_t masks[2] = {rule->birth, rule->survive};
+  // Column sums are rolled along the row so that each cell only costs one
+  //  new column sum rather than eight lookups
+#define COL_SUM(x)                                                             \
+  ((up ? up[x] : 0) + mid[x] + (down ? down[x] : 0))
+  int left = wrapping ? COL_SUM(cols - 1) : 0;
+  int centre = COL_SUM(0);
+  for (int x = 0; x < cols; x++) {
+    int right = 0;
+    if (x + 1 < cols) {
+      right = COL_SUM(x + 1);
+    } else if (wrapping) {
+      right = COL_SUM(0);
+    }
+    int neighbours = left + centre + right - mid[x];
+    out[x] = (masks[mid[x]] >> neighbours) & 1;
+    left = centre;
+    centre = right;
+  }
+#undef COL_SUM
+}
+
+/// Advance a single band of rows `[r0, r1)` by `gens` generations, reading
+///  from `src` and writing only the band's own rows to `dst`
+///
+/// The band is grown by `gens` halo rows on either side, each generation the
+///  valid region shrinks by one row at each cut edge, so that after `gens`
+///  generations exactly `[r0, r1)` remains valid. Board edges are only treated
+///  as cut edges when wrapping, otherwise they are inactive borders
+static void step_band(const uint8_t *src, uint8_t *dst, uint8_t *win[2],
+                      int lines, int cols, bool wrapping,
+                      const struct rule *rule, int r0, int r1, int gens) {
+  int a = r0 - gens, b = r1 + gens;
+  if (!wrapping) {
+    a = a < 0 ? 0 : a;
+    b = b > lines ? lines : b;
+  }
+  int n = b - a;
+  bool top_dead = !wrapping && a == 0;
+  bool bottom_dead = !wrapping && b == lines;
+
+  for (int i = 0; i < n; i++) {
+    int y = (a + i) % lines;
+    if (y < 0) {
+      y += lines;
+    }
+    memcpy(win[0] + ((size_t)i * cols), src + ((size_t)y * cols), cols);
+  }
+
+  int cur = 0;
+  for (int g = 1; g <= gens; g++) {
+    int lo = top_dead ? 0 : g;
+    int hi = bottom_dead ? n : n - g;
+    uint8_t *in = win[cur], *out = win[!cur];
+    for (int i = lo; i < hi; i++) {
+      const uint8_t *up = i > 0 ? in + ((size_t)(i - 1) * cols) : NULL;
+      const uint8_t *down = i + 1 < n ? in + ((size_t)(i + 1) * cols) : NULL;
+      step_row(up, in + ((size_t)i * cols), down, out + ((size_t)i * cols),
+               cols, wrapping, rule);
+    }
+    cur = !cur;
+  }
+
+  memcpy(dst + ((size_t)r0 * cols), win[cur] + ((size_t)(r0 - a) * cols),
+         (size_t)(r1 - r0) * cols);
+}
+
+/// Recount the population of the tiles covering rows `[r0, r1)`, `r0` must be
+///  aligned to `TILE_SIZE`
+void count_tile_rows(const uint8_t *cells, uint32_t *tile_pop, int cols,
+                     int r0, int r1) {
+  int tile_cols = (cols + TILE_SIZE - 1) / TILE_SIZE;
+  for (int y = r0; y < r1; y++) {
+    uint32_t *tile_row = tile_pop + ((size_t)(y / TILE_SIZE) * tile_cols);
+    if (y % TILE_SIZE == 0) {
+      memset(tile_row, 0, tile_cols * sizeof(uint32_t));
+    }
+    const uint8_t *row = cells + ((size_t)y * cols);
+    for (int x = 0; x < cols; x++) {
+      tile_row[x / TILE_SIZE] += row[x];
+    }
+  }
+}
+
+/// Record the cells of rows `[r0, r1)` which differ between `origin` and
+///  `cells`, in increasing order of index
+enum error_codes collect_flips(const uint8_t *origin, const uint8_t *cells,
+                               struct flip_set *flips, int cols, int r0,
+                               int r1) {
+  size_t end = (size_t)r1 * cols;
+  for (size_t i = (size_t)r0 * cols; i < end; i++) {
+    if (origin[i] != cells[i] && flip_set_push(flips, i) != E_SUCCESS) {
+      return E_ALLOC;
+    }
+  }
+  return E_SUCCESS;
+}
+
+/// Allocate an inactive board of the given dimensions, following Conway's rule
+///  until told otherwise
+///
+/// All of the board's memory comes from `alloc`, or `malloc` if it is NULL
+enum error_codes board_init(struct board *board, int lines, int cols,
+                            bool wrapping, const struct allocator *alloc) {
+  size_t n_cells = (size_t)lines * cols;
+  board->alloc = alloc ? *alloc : DEFAULT_ALLOCATOR;
+  board->lines = lines;
+  board->cols = cols;
+  board->tile_lines = (lines + TILE_SIZE - 1) / TILE_SIZE;
+  board->tile_cols = (cols + TILE_SIZE - 1) / TILE_SIZE;
+  size_t tiles_size =
+      (size_t)board->tile_lines * board->tile_cols * sizeof(uint32_t);
+  board->pool = NULL;
+  board->origin = NULL;
+  board->cells = board_alloc(board, n_cells);
+  board->scratch = board_alloc(board, n_cells);
+  board->windows = board_alloc(board, windows_size(board));
+  board->tile_pop = board_alloc(board, tiles_size);
+  if (!board->cells || !board->scratch || !board->windows ||
+      !board->tile_pop) {
+    board_free(board);
+    return E_ALLOC;
+  }
+  // Zeroed memory is left untouched, so that its pages are only placed once
+  //  first written by whichever thread steps those rows
+  if (!board->alloc.zeroed) {
+    memset(board->cells, 0, n_cells);
+    memset(board->scratch, 0, n_cells);
+    memset(board->tile_pop, 0, tiles_size);
+  }
+  board->wrapping = wrapping;
+  board->rule = CONWAY_RULE;
+  board->generation = 0;
+  return E_SUCCESS;
+}
+
+void board_free(struct board *board) {
+  if (!board->alloc.free) {
+    return;
+  }
+  // Sized by the pool's threads, so released before the pool
+  board_release(board, board->windows, windows_size(board));
+  board->windows = NULL;
+  if (board->pool) {
+    pool_free(board->pool);
+    free(board->pool);
+    board->pool = NULL;
+  }
+  size_t n_cells = (size_t)board->lines * board->cols;
+  board_release(board, board->cells, n_cells);
+  board_release(board, board->scratch, n_cells);
+  board_release(board, board->origin, n_cells);
+  board_release(board, board->tile_pop,
+                (size_t)board->tile_lines * board->tile_cols *
+                    sizeof(uint32_t));
+  board->cells = NULL;
+  board->scratch = NULL;
+  board->origin = NULL;
+  board->tile_pop = NULL;
+  board->lines = 0;
+  board->cols = 0;
+  board->tile_lines = 0;
+  board->tile_cols = 0;
+}
+
+/// Copy the overlapping top-left region of `cells` into the board
+void blit_cells(struct board *board, const uint8_t *cells, int lines,
+                int cols) {
+  int min_lines = min(lines, board->lines);
+  int min_cols = min(cols, board->cols);
+  for (int i = 0; i < min_lines; i++) {
+    memcpy(board->cells + ((size_t)i * board->cols),
+           cells + ((size_t)i * cols), min_cols);
+  }
+  recount_tiles(board);
+}
+
+/// Recount the population of every tile, for when the cells have been replaced
+///  wholesale
+void recount_tiles(struct board *board) {
+  count_tile_rows(board->cells, board->tile_pop, board->cols, 0, board->lines);
+}
+
+/// Rows `[r0, r1)` stepped by thread `t` of `threads`, whole bands so that
+///  the same thread always steps, and first touched, the same rows
+static void thread_rows(const struct board *board, int t, int threads,
+                        int *r0, int *r1) {
+  int bands = (board->lines + BAND_ROWS - 1) / BAND_ROWS;
+  *r0 = min((int)(((long)t * bands) / threads) * BAND_ROWS, board->lines);
+  *r1 = min((int)(((long)(t + 1) * bands) / threads) * BAND_ROWS,
+            board->lines);
+}
+
+/// A single thread's share of an `iterate`
+struct step_work {
+  struct board *board;
+  struct band_pool *pool;
+  uint8_t *origin;
+  struct flip_set *flips;
+  uint8_t *win[2];
+  long steps;
+  int r0;
+  int r1;
+  enum error_codes ec;
+};
+
+/// Advance the rows of `work` by its steps, in chunks of `BLOCK_GENS`
+///
+/// Every thread must have written its rows of one chunk before any reads them
+///  for the next, so threads meet between chunks
+static void step_rows(struct step_work *work) {
+  struct board *board = work->board;
+  int lines = board->lines, cols = board->cols;
+  uint8_t *src = board->cells, *dst = board->scratch;
+  const uint8_t *origin = src;
+  if (work->origin) {
+    size_t offset = (size_t)work->r0 * cols;
+    memcpy(work->origin + offset, src + offset,
+           (size_t)(work->r1 - work->r0) * cols);
+    origin = work->origin;
+  }
+
+  for (long steps = work->steps; steps > 0;) {
+    int gens = steps < BLOCK_GENS ? steps : BLOCK_GENS;
+    for (int r0 = work->r0; r0 < work->r1; r0 += BAND_ROWS) {
+      int r1 = min(r0 + BAND_ROWS, work->r1);
+      step_band(src, dst, work->win, lines, cols, board->wrapping,
+                &board->rule, r0, r1, gens);
+      if (steps == gens) {
+        count_tile_rows(dst, board->tile_pop, cols, r0, r1);
+        if (work->flips && work->ec == E_SUCCESS) {
+          work->ec = collect_flips(origin, dst, work->flips, cols, r0, r1);
+        }
+      }
+    }
+    steps -= gens;
+    if (steps > 0 && work->pool) {
+      pool_sync(work->pool);
+    }
+    uint8_t *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+}
+
+static void step_job(void *arg, int t) {
+  step_rows((struct step_work *)arg + t);
+}
+
+/// Iterate the board `steps` times by the game of life rules using
+///  temporally blocked bands
+///  - Each band is advanced up to `BLOCK_GENS` generations while its rows are
+///    still cache-resident, rather than sweeping the whole board per
+///    generation
+///  - With a thread pool, each thread steps the same contiguous run of bands
+///    every time
+///  - The tile populations of each band are recounted as the band's final
+///    generation is written
+///  - If `flips` is given, it is refilled with the cells which differ between
+///    the first and last generation
+enum error_codes iterate(struct board *board, long steps,
+                         struct flip_set *flips) {
+  int lines = board->lines, cols = board->cols;
+  if (flips) {
+    flips->len = 0;
+  }
+  if (lines <= 0 || cols <= 0 || steps <= 0) {
+    return E_SUCCESS;
+  }
+  if (!board->windows) {
+    return E_ALLOC;
+  }
+
+  int threads = board->pool ? board->pool->threads : 1;
+  // The starting generation is only still intact at the final write when the
+  //  steps fit in a single block, otherwise it must be kept aside. The copy is
+  //  only allocated once needed, each thread then first writing its own rows
+  //  of it
+  bool keep_origin = flips && steps > BLOCK_GENS;
+  if (keep_origin && !board->origin) {
+    board->origin = board_alloc(board, (size_t)lines * cols);
+  }
+  struct step_work *work = calloc(threads, sizeof(struct step_work));
+  struct flip_set *thread_flips = NULL;
+  if (flips && threads > 1) {
+    thread_flips = calloc(threads, sizeof(struct flip_set));
+  }
+  if ((keep_origin && !board->origin) || !work ||
+      (flips && threads > 1 && !thread_flips)) {
+    free(work);
+    free(thread_flips);
+    return E_ALLOC;
+  }
+
+  size_t win_rows = BAND_ROWS + (2 * BLOCK_GENS);
+  for (int t = 0; t < threads; t++) {
+    uint8_t *win = board->windows + ((size_t)t * 2 * win_rows * cols);
+    work[t] = (struct step_work){
+        .board = board,
+        .pool = board->pool,
+        .origin = keep_origin ? board->origin : NULL,
+        .flips = thread_flips ? thread_flips + t : flips,
+        .win = {win, win + ((size_t)win_rows * cols)},
+        .steps = steps,
+        .ec = E_SUCCESS,
+    };
+    thread_rows(board, t, threads, &work[t].r0, &work[t].r1);
+  }
+
+  if (board->pool) {
+    pool_run(board->pool, step_job, work);
+  } else {
+    step_rows(work);
+  }
+
+  // Each thread collected the flips of its own rows, in order of rows
+  enum error_codes ec = E_SUCCESS;
+  for (int t = 0; t < threads; t++) {
+    if (work[t].ec != E_SUCCESS) {
+      ec = work[t].ec;
+    }
+    for (size_t i = 0; thread_flips && i < thread_flips[t].len; i++) {
+      if (ec == E_SUCCESS) {
+        ec = flip_set_push(flips, thread_flips[t].idx[i]);
+      }
+    }
+    if (thread_flips) {
+      flip_set_free(thread_flips + t);
+    }
+  }
+
+  // The board's buffers swap once per chunk of `BLOCK_GENS`
+  board->generation += steps;
+  if (((steps + BLOCK_GENS - 1) / BLOCK_GENS) % 2) {
+    uint8_t *tmp = board->cells;
+    board->cells = board->scratch;
+    board->scratch = tmp;
+  }
+
+  free(work);
+  free(thread_flips);
+
+  return ec;
+}
+
+/// Append a cell index to the flip set, growing it as required
+enum error_codes flip_set_push(struct flip_set *flips, size_t idx) {
+  if (flips->len == flips->cap) {
+    size_t cap = flips->cap ? flips->cap * 2 : 1024;
+    size_t *new_idx = realloc(flips->idx, cap * sizeof(size_t));
+    if (!new_idx) {
+      return E_ALLOC;
+    }
+    flips->idx = new_idx;
+    flips->cap = cap;
+  }
+  flips->idx[flips->len++] = idx;
+  return E_SUCCESS;
+}
+
+void flip_set_free(struct flip_set *flips) {
+  free(flips->idx);
+  flips->idx = NULL;
+  flips->len = 0;
+  flips->cap = 0;
+}
+
+/// Calculate the count of active neighbours surrounding a particular cell
+int count_neighbours(struct board *board, int y, int x) {
+  int neighbours = 0;
+  for (int i = -1; i <= 1; i++) {
+    for (int j = -1; j <= 1; j++) {
+      // We don't count an active cell as a neighbour of itself
+      if (i == 0 && j == 0) {
+        continue;
+      }
+      int _y = y + i, _x = x + j;
+      if (board->wrapping) {
+        _y = (_y + board->lines) % board->lines;
+        _x = (_x + board->cols) % board->cols;
+      }
+      neighbours += cell_is_active(board, _y, _x);
+    }
+  }
+  return neighbours;
+}
+
+/// Whether the cell at the given coordinates is active, coordinates outside
+///  of the board are considered inactive
+bool cell_is_active(struct board *board, int y, int x) {
+  if (y < 0 || y >= board->lines || x < 0 || x >= board->cols) {
+    return false;
+  }
+  return *get_cell(board, y, x);
+}
+
+uint8_t *get_cell(struct board *board, int y, int x) {
+  return board->cells + (((size_t)y * board->cols) + x);
+}
+
+int flip_by_cords(struct board *board, int y, int x) {
+  uint8_t *cell = get_cell(board, y, x);
+  *cell = !*cell;
+  uint32_t *pop = board->tile_pop + (((size_t)(y / TILE_SIZE) *
+                                      board->tile_cols) +
+                                     (x / TILE_SIZE));
+  *pop = *cell ? *pop + 1 : *pop - 1;
+  return *cell;
+}
+
+/// Sum the populations of the tiles covering rows `[t0, t1)` and columns
+///  `[u0, u1)` of tiles, ranges are clipped to the board
+uint64_t tile_range_pop(struct board *board, int t0, int t1, int u0, int u1) {
+  t1 = min(t1, board->tile_lines);
+  u1 = min(u1, board->tile_cols);
+  uint64_t pop = 0;
+  for (int t = t0; t < t1; t++) {
+    const uint32_t *tile_row =
+        board->tile_pop + ((size_t)t * board->tile_cols);
+    for (int u = u0; u < u1; u++) {
+      pop += tile_row[u];
+    }
+  }
+  return pop;
+}
+
+/// Make a backup of board into board_bak
+enum error_codes make_backup(struct board *board_bak, struct board *board) {
+  if (board_bak->lines != board->lines || board_bak->cols != board->cols) {
+    board_free(board_bak);
+    enum error_codes ec = board_init(board_bak, board->lines, board->cols,
+                                     board->wrapping, &board->alloc);
+    if (ec != E_SUCCESS) {
+      return ec;
+    }
+  }
+  memcpy(board_bak->cells, board->cells,
+         (size_t)board->lines * board->cols);
+  memcpy(board_bak->tile_pop, board->tile_pop,
+         (size_t)board->tile_lines * board->tile_cols * sizeof(uint32_t));
+  board_bak->rule = board->rule;
+  board_bak->generation = board->generation;
+  return E_SUCCESS;
+}
+
+/// Write back one byte of every page of this thread's rows, so that those
+///  pages are placed on its node
+static void touch_job(void *arg, int t) {
+  struct board *board = arg;
+  size_t page = sysconf(_SC_PAGESIZE);
+  int r0, r1;
+  thread_rows(board, t, board->pool->threads, &r0, &r1);
+  uint8_t *bufs[2] = {board->cells, board->scratch};
+  for (int b = 0; b < 2; b++) {
+    volatile uint8_t *buf = bufs[b];
+    size_t end = (size_t)r1 * board->cols;
+    for (size_t i = (size_t)r0 * board->cols; i < end; i += page) {
+      buf[i] = buf[i];
+    }
+  }
+  size_t win_size = windows_size(board) / board->pool->threads;
+  volatile uint8_t *win = board->windows + ((size_t)t * win_size);
+  for (size_t i = 0; i < win_size; i += page) {
+    win[i] = win[i];
+  }
+}
+
+/// Step the board on a pool of `threads` threads, first touching each
+///  thread's rows from that thread
+///
+/// The first touch only places pages which have not yet been written, i.e.
+///  those of a board from a `zeroed` allocator before it is filled
+enum error_codes board_set_threads(struct board *board, int threads) {
+  // The windows are sized by the threads and the origin placed by them, so
+  //  both are made afresh for the new pool
+  board_release(board, board->windows, windows_size(board));
+  board_release(board, board->origin, (size_t)board->lines * board->cols);
+  board->windows = NULL;
+  board->origin = NULL;
+  if (board->pool) {
+    pool_free(board->pool);
+    free(board->pool);
+    board->pool = NULL;
+  }
+  enum error_codes ec = E_SUCCESS;
+  if (threads >= 2) {
+    struct band_pool *pool = malloc(sizeof(struct band_pool));
+    ec = pool ? pool_init(pool, threads) : E_ALLOC;
+    if (ec == E_SUCCESS) {
+      board->pool = pool;
+    } else {
+      free(pool);
+    }
+  }
+  board->windows = board_alloc(board, windows_size(board));
+  if (!board->windows) {
+    return E_ALLOC;
+  }
+  if (board->pool) {
+    pool_run(board->pool, touch_job, board);
+  }
+  return ec;
+}
@@ -0,0 +1,260 @@
+#include "engine.h"
+
+/// Records between forced keyframes, bounding the deltas applied per rewind
+#define KEYFRAME_INTERVAL 64
+
+/// Bytes of the budget set aside per record descriptor, bounding the depth of
+///  the history when records are small or empty
+#define BYTES_PER_RECORD 1024
+
+/// Allocate the history's pool and record descriptors, which together take up
+///  `mb` megabytes, a `mb` of zero disables the history
+enum error_codes history_init(struct history *hist, int mb) {
+  memset(hist, 0, sizeof(struct history));
+  if (mb <= 0) {
+    return E_SUCCESS;
+  }
+  size_t budget = (size_t)mb << 20;
+  hist->slots = budget / BYTES_PER_RECORD;
+  hist->capacity = budget - (hist->slots * sizeof(struct history_record));
+  hist->records = malloc(hist->slots * sizeof(struct history_record));
+  hist->pool = malloc(hist->capacity);
+  if (!hist->records || !hist->pool) {
+    history_free(hist);
+    return E_ALLOC;
+  }
+  return E_SUCCESS;
+}
+
+void history_free(struct history *hist) {
+  free(hist->pool);
+  free(hist->records);
+  memset(hist, 0, sizeof(struct history));
+}
+
+/// Forget every record, for when the board has been replaced wholesale
+void history_clear(struct history *hist) {
+  hist->first = 0;
+  hist->count = 0;
+  hist->since_keyframe = 0;
+}
+
+/// The record `i` places from the newest
+static struct history_record *nth_newest(struct history *hist, int i) {
+  return hist->records + ((hist->first + hist->count - 1 - i) % hist->slots);
+}
+
+/// Bytes of the pool taken by a record, empty records still take a byte so that
+///  no two records ever share an offset
+static size_t record_span(size_t len) { return len ? len : 1; }
+
+/// Find room in the pool for `len` bytes, evicting the oldest records until it
+///  fits
+///
+/// Records are laid out in the pool in order, wrapping to the start of the
+///  pool when a record does not fit before its end, so the free space is
+///  always either side of the occupied region or the gap within it
+static bool reserve(struct history *hist, size_t len, size_t *offset) {
+  if (len > hist->capacity) {
+    history_clear(hist);
+    return false;
+  }
+  for (;;) {
+    if (!hist->count) {
+      *offset = 0;
+      return true;
+    }
+    struct history_record *oldest = hist->records + hist->first;
+    struct history_record *newest = nth_newest(hist, 0);
+    size_t tail = newest->offset + record_span(newest->len);
+    if (newest->offset >= oldest->offset) {
+      if (tail + len <= hist->capacity) {
+        *offset = tail;
+        return true;
+      }
+      if (len <= oldest->offset) {
+        *offset = 0;
+        return true;
+      }
+    } else if (tail + len <= oldest->offset) {
+      *offset = tail;
+      return true;
+    }
+    hist->first = (hist->first + 1) % hist->slots;
+    hist->count--;
+  }
+}
+
+/// Bytes needed to encode the flips as LEB128 gaps between increasing indices
+size_t delta_len(const struct flip_set *flips) {
+  size_t len = 0, prev = 0;
+  for (size_t i = 0; i < flips->len; i++) {
+    size_t gap = flips->idx[i] - prev;
+    prev = flips->idx[i];
+    do {
+      len++;
+      gap >>= 7;
+    } while (gap);
+  }
+  return len;
+}
+
+void encode_delta(const struct flip_set *flips, uint8_t *out) {
+  size_t prev = 0;
+  for (size_t i = 0; i < flips->len; i++) {
+    size_t gap = flips->idx[i] - prev;
+    prev = flips->idx[i];
+    do {
+      uint8_t byte = gap & 0x7f;
+      gap >>= 7;
+      *out++ = byte | (gap ? 0x80 : 0);
+    } while (gap);
+  }
+}
+
+/// Decode the next LEB128 gap of a delta ending at `end`, failing if it is
+///  truncated or longer than a `size_t`
+bool decode_gap(const uint8_t **in, const uint8_t *end, size_t *gap) {
+  *gap = 0;
+  for (int shift = 0; *in < end && shift < 64; shift += 7) {
+    uint8_t byte = *(*in)++;
+    *gap |= (size_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Flip every cell of a delta, flips being their own inverse this both
+///  applies and reverts it
+///
+/// Deltas may come from outside the process, one which is malformed or
+///  reaches beyond the board is rejected before any cell is flipped
+enum error_codes apply_delta(struct board *board, const uint8_t *in,
+                             size_t len) {
+  const uint8_t *end = in + len;
+  size_t idx = 0, gap, n_cells = (size_t)board->lines * board->cols;
+  for (const uint8_t *p = in; p < end; idx += gap) {
+    if (!decode_gap(&p, end, &gap) || gap >= n_cells - idx) {
+      return E_IO;
+    }
+  }
+  idx = 0;
+  while (in < end) {
+    decode_gap(&in, end, &gap);
+    idx += gap;
+    flip_by_cords(board, idx / board->cols, idx % board->cols);
+  }
+  return E_SUCCESS;
+}
+
+/// Pack the state preceding `flips` into a bitmap, one bit per cell
+void encode_keyframe(struct board *board, const struct flip_set *flips,
+                            uint8_t *out) {
+  size_t n_cells = (size_t)board->lines * board->cols;
+  memset(out, 0, (n_cells + 7) / 8);
+  for (size_t i = 0; i < n_cells; i++) {
+    out[i / 8] |= board->cells[i] << (i % 8);
+  }
+  for (size_t i = 0; i < flips->len; i++) {
+    out[flips->idx[i] / 8] ^= 1 << (flips->idx[i] % 8);
+  }
+}
+
+void apply_keyframe(struct board *board, const uint8_t *in) {
+  size_t n_cells = (size_t)board->lines * board->cols;
+  for (size_t i = 0; i < n_cells; i++) {
+    board->cells[i] = (in[i / 8] >> (i % 8)) & 1;
+  }
+  recount_tiles(board);
+}
+
+/// Record the state of the board at `generation`, from which it has since been
+///  changed by `flips`
+///
+/// The record is stored as the flips themselves, unless they would take more
+///  room than a keyframe of the whole state or a keyframe is due. Boards whose
+///  keyframes do not fit in the pool only ever record flips. When the record
+///  cannot be made the history is cleared, as older records would no longer
+///  lead back from the current state
+enum error_codes history_push(struct history *hist, struct board *board,
+                              long generation, const struct flip_set *flips) {
+  if (!hist->pool) {
+    return E_SUCCESS;
+  }
+  size_t keyframe_len = (((size_t)board->lines * board->cols) + 7) / 8;
+  size_t len = delta_len(flips);
+  bool keyframe = (hist->since_keyframe + 1 >= KEYFRAME_INTERVAL ||
+                   len >= keyframe_len) &&
+                  keyframe_len <= hist->capacity;
+  if (keyframe) {
+    len = keyframe_len;
+  }
+
+  // The oldest record makes way when every descriptor is in use
+  if (hist->count == hist->slots) {
+    hist->first = (hist->first + 1) % hist->slots;
+    hist->count--;
+  }
+  size_t offset;
+  if (!reserve(hist, record_span(len), &offset)) {
+    return E_ALLOC;
+  }
+
+  uint8_t *data = hist->pool + offset;
+  if (keyframe) {
+    encode_keyframe(board, flips, data);
+    hist->since_keyframe = 0;
+  } else {
+    encode_delta(flips, data);
+    hist->since_keyframe++;
+  }
+
+  hist->records[(hist->first + hist->count) % hist->slots] =
+      (struct history_record){.offset = offset,
+                              .len = len,
+                              .generation = generation,
+                              .keyframe = keyframe};
+  hist->count++;
+
+  return E_SUCCESS;
+}
+
+/// Rewind the board by up to `n` records, returning the number rewound
+///
+/// Rather than walking back through every delta, the board jumps straight to
+///  the keyframe closest to the target and only the deltas between the two
+///  are applied
+int history_rewind(struct history *hist, struct board *board, int n) {
+  n = min(n, hist->count);
+  if (n <= 0) {
+    return 0;
+  }
+
+  int from = 0;
+  for (int i = n - 1; i >= 0; i--) {
+    struct history_record *rec = nth_newest(hist, i);
+    if (rec->keyframe) {
+      apply_keyframe(board, hist->pool + rec->offset);
+      from = i + 1;
+      break;
+    }
+  }
+  for (int i = from; i < n; i++) {
+    struct history_record *rec = nth_newest(hist, i);
+    apply_delta(board, hist->pool + rec->offset, rec->len);
+  }
+
+  board->generation = nth_newest(hist, n - 1)->generation;
+  hist->count -= n;
+
+  // Counting from the newest remaining keyframe keeps the interval honest
+  hist->since_keyframe = 0;
+  while (hist->since_keyframe < hist->count &&
+         !nth_newest(hist, hist->since_keyframe)->keyframe) {
+    hist->since_keyframe++;
+  }
+
+  return n;
+}
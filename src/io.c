@@ -0,0 +1,324 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "engine.h"
+
+/// Bytes encoded at a time by each thread of an export, bounding the memory an
+///  export takes however large the board
+#define EXPORT_CHUNK ((size_t)1 << 20)
+
+/// Packed files start with this magic, followed by the lines and cols as
+///  little-endian 32 bit integers, then each row packed 8 cells to the byte
+static const char PACKED_MAGIC[8] = {'G', 'O', 'L', 'C', 'P', 'A', 'K', '1'};
+
+#define PACKED_HEADER_LEN 16
+
+/// An export of a board split into `EXPORT_CHUNK` sized chunks of the file's
+///  body, each thread encoding and writing a contiguous run of them
+struct export_job {
+  struct board *board;
+  enum cell_format format;
+  int fd;
+  size_t header_len;
+  size_t body_len;
+  size_t n_chunks;
+  int threads;
+  enum error_codes *ec;
+};
+
+/// Bytes taken by a single row of the board in the given format
+static size_t row_bytes(struct board *board, enum cell_format format) {
+  if (format == FORMAT_PACKED) {
+    return ((size_t)board->cols + 7) / 8;
+  }
+  return (size_t)board->cols + 1;
+}
+
+/// Encode bytes `[off, off + len)` of a text body, one line of 'A' (active)
+///  and '_' (inactive) characters per row
+static void encode_text(struct board *board, size_t off, size_t len,
+                        uint8_t *out) {
+  size_t cols = board->cols;
+  size_t y = off / (cols + 1), x = off % (cols + 1);
+  for (size_t i = 0; i < len;) {
+    if (x == cols) {
+      out[i++] = '\n';
+      x = 0, y++;
+      continue;
+    }
+    const uint8_t *row = board->cells + (y * cols);
+    size_t n = cols - x < len - i ? cols - x : len - i;
+    for (size_t j = 0; j < n; j++) {
+      out[i + j] = row[x + j] ? 'A' : '_';
+    }
+    i += n, x += n;
+  }
+}
+
+/// Encode bytes `[off, off + len)` of a packed body, bit `n` of each byte
+///  being the `n`th of its 8 cells
+static void encode_packed(struct board *board, size_t off, size_t len,
+                          uint8_t *out) {
+  size_t cols = board->cols, stride = (cols + 7) / 8;
+  size_t y = off / stride, b = off % stride;
+  for (size_t i = 0; i < len; i++) {
+    const uint8_t *row = board->cells + (y * cols);
+    uint8_t byte = 0;
+    for (size_t x = b * 8, bit = 0; bit < 8 && x < cols; x++, bit++) {
+      byte |= row[x] << bit;
+    }
+    out[i] = byte;
+    if (++b == stride) {
+      b = 0, y++;
+    }
+  }
+}
+
+/// Write the whole of `buf` at `offset`, however many calls that takes
+static enum error_codes pwrite_all(int fd, const uint8_t *buf, size_t len,
+                                   off_t offset) {
+  while (len) {
+    ssize_t n = pwrite(fd, buf, len, offset);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return E_IO;
+    }
+    buf += n, len -= n, offset += n;
+  }
+  return E_SUCCESS;
+}
+
+static void export_job(void *arg, int t) {
+  struct export_job *job = arg;
+  size_t c0 = (t * job->n_chunks) / job->threads;
+  size_t c1 = ((t + 1) * job->n_chunks) / job->threads;
+  job->ec[t] = E_SUCCESS;
+  if (c0 == c1) {
+    return;
+  }
+  uint8_t *buf = malloc(EXPORT_CHUNK);
+  if (!buf) {
+    job->ec[t] = E_ALLOC;
+    return;
+  }
+  for (size_t c = c0; c < c1 && job->ec[t] == E_SUCCESS; c++) {
+    size_t off = c * EXPORT_CHUNK;
+    size_t len = job->body_len - off < EXPORT_CHUNK ? job->body_len - off
+                                                     : EXPORT_CHUNK;
+    if (job->format == FORMAT_PACKED) {
+      encode_packed(job->board, off, len, buf);
+    } else {
+      encode_text(job->board, off, len, buf);
+    }
+    job->ec[t] = pwrite_all(job->fd, buf, len, job->header_len + off);
+  }
+  free(buf);
+}
+
+/// Write the board's state to the given file in the given format
+///
+/// Chunks of the file are encoded in parallel, each being written straight to
+///  its offset in the file, so the whole file is never held in memory. The
+///  board's own thread pool is used if it has one, so that each thread
+///  encodes rows it first touched, otherwise one is started for the export
+///  - E_IO with `errno` set if the file could not be written
+enum error_codes write_cells(const char *path, struct board *board,
+                             enum cell_format format) {
+  errno = 0;
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    return E_IO;
+  }
+
+  struct export_job job = {
+      .board = board,
+      .format = format,
+      .fd = fd,
+      .header_len = format == FORMAT_PACKED ? PACKED_HEADER_LEN : 0,
+      .body_len = row_bytes(board, format) * board->lines,
+  };
+  job.n_chunks = (job.body_len + EXPORT_CHUNK - 1) / EXPORT_CHUNK;
+
+  enum error_codes ec = E_SUCCESS;
+  if (format == FORMAT_PACKED) {
+    uint8_t header[PACKED_HEADER_LEN];
+    memcpy(header, PACKED_MAGIC, sizeof(PACKED_MAGIC));
+    for (int i = 0; i < 4; i++) {
+      header[8 + i] = ((uint32_t)board->lines >> (8 * i)) & 0xff;
+      header[12 + i] = ((uint32_t)board->cols >> (8 * i)) & 0xff;
+    }
+    ec = pwrite_all(fd, header, PACKED_HEADER_LEN, 0);
+  }
+  // Sizing the file up front saves extending it with every write
+  if (ec == E_SUCCESS &&
+      ftruncate(fd, job.header_len + job.body_len) == -1) {
+    ec = E_IO;
+  }
+
+  struct band_pool own_pool = {.ids = NULL};
+  struct band_pool *pool = board->pool;
+  if (ec == E_SUCCESS && !pool && job.n_chunks > 1) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus < 1 ? 1 : cpus;
+    if ((size_t)threads > job.n_chunks) {
+      threads = job.n_chunks;
+    }
+    if (threads > 1 && pool_init(&own_pool, threads) == E_SUCCESS) {
+      pool = &own_pool;
+    }
+  }
+  job.threads = pool ? pool->threads : 1;
+  job.ec = calloc(job.threads, sizeof(enum error_codes));
+  if (ec == E_SUCCESS && !job.ec) {
+    ec = E_ALLOC;
+  }
+
+  if (ec == E_SUCCESS) {
+    if (pool) {
+      pool_run(pool, export_job, &job);
+    } else {
+      export_job(&job, 0);
+    }
+    for (int t = 0; t < job.threads; t++) {
+      if (job.ec[t] != E_SUCCESS) {
+        ec = job.ec[t];
+      }
+    }
+  }
+  pool_free(&own_pool);
+  free(job.ec);
+  if (close(fd) == -1 && ec == E_SUCCESS) {
+    ec = E_IO;
+  }
+
+  return ec;
+}
+
+/// Read a packed file, its magic having already been read
+static enum error_codes read_packed(FILE *fp, struct InfileData *infile_data) {
+  uint8_t dims[8];
+  if (fread(dims, 1, sizeof(dims), fp) != sizeof(dims)) {
+    return E_IO;
+  }
+  uint32_t lines = 0, cols = 0;
+  for (int i = 0; i < 4; i++) {
+    lines |= (uint32_t)dims[i] << (8 * i);
+    cols |= (uint32_t)dims[4 + i] << (8 * i);
+  }
+  if (!lines || !cols || lines > INT32_MAX || cols > INT32_MAX) {
+    return E_IO;
+  }
+
+  size_t stride = ((size_t)cols + 7) / 8;
+  uint8_t *row = malloc(stride);
+  uint8_t *cells = malloc((size_t)lines * cols);
+  if (!row || !cells) {
+    free(row);
+    free(cells);
+    return E_ALLOC;
+  }
+  for (size_t y = 0; y < lines; y++) {
+    if (fread(row, 1, stride, fp) != stride) {
+      free(row);
+      free(cells);
+      return E_IO;
+    }
+    uint8_t *out = cells + (y * cols);
+    for (size_t x = 0; x < cols; x++) {
+      out[x] = (row[x / 8] >> (x % 8)) & 1;
+    }
+  }
+  free(row);
+
+  infile_data->cells = cells;
+  infile_data->lines = lines;
+  infile_data->cols = cols;
+  return E_SUCCESS;
+}
+
+/// Read a buffer of cells from the given filename, of the size indicated by the
+///  contents, packed files being told apart from text by their magic
+///  - E_IO with `errno` set if the file could not be read, or left alone if
+///    it is not a board, nothing is printed either way
+///
+/// WARN: This function allocated memory (for the buffer), but does not free it,
+///       that is left to the calling function
+enum error_codes read_cells(const char *path, struct InfileData *infile_data) {
+  FILE *fp = fopen(path, "rb");
+  if (!fp) {
+    return E_IO;
+  }
+
+  char magic[sizeof(PACKED_MAGIC)];
+  if (fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+      !memcmp(magic, PACKED_MAGIC, sizeof(magic))) {
+    enum error_codes ec = read_packed(fp, infile_data);
+    fclose(fp);
+    return ec;
+  }
+  rewind(fp);
+
+  int lines = 0, cols = 0;
+
+  int ch, last = '\n';
+  // Naive dimension calculation based on newlines, a final row without a
+  //  trailing newline still counts
+  while ((ch = fgetc(fp)) != EOF) {
+    if (ch == '\n') {
+      lines++;
+    } else if (!lines) {
+      cols++;
+    }
+    last = ch;
+  }
+  if (ferror(fp)) {
+    fclose(fp);
+    return E_IO;
+  }
+  if (last != '\n') {
+    lines++;
+  }
+  rewind(fp);
+
+  int buf_size = lines * cols;
+  if (buf_size <= 0) {
+    fclose(fp);
+    return E_IO;
+  }
+
+  uint8_t *cells = malloc(buf_size);
+  if (!cells) {
+    fclose(fp);
+    return E_ALLOC;
+  }
+
+  // Translate simple chars ['_', 'A'] to active (1) and inactive (0) cells
+  for (int i = 0; i < lines; i++) {
+    for (int j = 0; j < cols; j++) {
+      ch = fgetc(fp);
+      if (ch == '\n') {
+        free(cells);
+        fclose(fp);
+        return E_IO;
+      }
+      *(cells + (i * cols) + j) = ch == 'A';
+    }
+    if ((ch = fgetc(fp)) != '\n' && !(ch == EOF && i + 1 == lines)) {
+      free(cells);
+      fclose(fp);
+      return E_IO;
+    }
+  }
+
+  infile_data->cells = cells;
+  infile_data->lines = lines;
+  infile_data->cols = cols;
+
+  fclose(fp);
+
+  return E_SUCCESS;
+}
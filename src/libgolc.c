@@ -0,0 +1,196 @@
+#include "libgolc.h"
+#include "engine.h"
+
+struct golc_board {
+  struct board board;
+};
+
+static golc_status to_status(enum error_codes ec) {
+  switch (ec) {
+  case E_SUCCESS:
+    return GOLC_OK;
+  case E_ALLOC:
+    return GOLC_ENOMEM;
+  case E_IO:
+    return GOLC_EIO;
+  default:
+    return GOLC_EINVAL;
+  }
+}
+
+/// Whether `rect` is non-empty and lies entirely within the board
+static bool rect_in_board(const struct board *board, golc_rect rect) {
+  return rect.lines > 0 && rect.cols > 0 && rect.y >= 0 && rect.x >= 0 &&
+         rect.y + rect.lines <= board->lines &&
+         rect.x + rect.cols <= board->cols;
+}
+
+golc_status golc_create(golc_board **out, int lines, int cols,
+                        const char *rule, bool wrapping,
+                        const golc_allocator *alloc) {
+  if (!out || lines <= 0 || cols <= 0) {
+    return GOLC_EINVAL;
+  }
+  struct rule parsed = CONWAY_RULE;
+  if (rule && parse_rule(rule, &parsed) != E_SUCCESS) {
+    return GOLC_EINVAL;
+  }
+
+  struct allocator board_alloc = {.alloc = NULL};
+  if (alloc) {
+    board_alloc = (struct allocator){
+        .alloc = alloc->alloc, .free = alloc->free, .ctx = alloc->ctx};
+  }
+
+  golc_board *handle =
+      alloc ? alloc->alloc(sizeof(golc_board), alloc->ctx)
+            : malloc(sizeof(golc_board));
+  if (!handle) {
+    return GOLC_ENOMEM;
+  }
+  enum error_codes ec = board_init(&handle->board, lines, cols, wrapping,
+                                   alloc ? &board_alloc : NULL);
+  if (ec != E_SUCCESS) {
+    if (alloc) {
+      alloc->free(handle, sizeof(golc_board), alloc->ctx);
+    } else {
+      free(handle);
+    }
+    return to_status(ec);
+  }
+  handle->board.rule = parsed;
+
+  *out = handle;
+  return GOLC_OK;
+}
+
+golc_status golc_load(golc_board **out, const char *path, const char *rule,
+                      bool wrapping, const golc_allocator *alloc) {
+  struct InfileData data = {.cells = NULL};
+  enum error_codes ec = read_cells(path, &data);
+  if (ec != E_SUCCESS) {
+    return to_status(ec);
+  }
+  golc_status status =
+      golc_create(out, data.lines, data.cols, rule, wrapping, alloc);
+  if (status == GOLC_OK) {
+    blit_cells(&(*out)->board, data.cells, data.lines, data.cols);
+  }
+  free(data.cells);
+  return status;
+}
+
+void golc_destroy(golc_board *handle) {
+  if (!handle) {
+    return;
+  }
+  struct allocator alloc = handle->board.alloc;
+  board_free(&handle->board);
+  alloc.free(handle, sizeof(golc_board), alloc.ctx);
+}
+
+golc_status golc_save(golc_board *handle, const char *path) {
+  return to_status(write_cells(path, &handle->board, FORMAT_TEXT));
+}
+
+golc_status golc_step(golc_board *handle, long n) {
+  if (n < 0) {
+    return GOLC_EINVAL;
+  }
+  return to_status(iterate(&handle->board, n, NULL));
+}
+
+long golc_generation(const golc_board *handle) {
+  return handle->board.generation;
+}
+
+void golc_dimensions(const golc_board *handle, int *lines, int *cols) {
+  *lines = handle->board.lines;
+  *cols = handle->board.cols;
+}
+
+uint64_t golc_population(const golc_board *handle) {
+  struct board *board = (struct board *)&handle->board;
+  return tile_range_pop(board, 0, board->tile_lines, 0, board->tile_cols);
+}
+
+/// Whether any cell of rows `[y0, y1)` and columns `[x0, x1)` is active
+static bool any_active(struct board *board, int y0, int y1, int x0, int x1) {
+  for (int y = y0; y < y1; y++) {
+    const uint8_t *row = get_cell(board, y, 0);
+    for (int x = x0; x < x1; x++) {
+      if (row[x]) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/// The tile populations narrow the search down to the outermost populated
+///  tiles, only the cells within those are scanned
+bool golc_bounding_box(const golc_board *handle, golc_rect *rect) {
+  struct board *board = (struct board *)&handle->board;
+  int t0 = board->tile_lines, t1 = -1, u0 = board->tile_cols, u1 = -1;
+  for (int t = 0; t < board->tile_lines; t++) {
+    for (int u = 0; u < board->tile_cols; u++) {
+      if (board->tile_pop[((size_t)t * board->tile_cols) + u]) {
+        t0 = min(t0, t), t1 = max(t1, t);
+        u0 = min(u0, u), u1 = max(u1, u);
+      }
+    }
+  }
+  if (t1 < 0) {
+    return false;
+  }
+
+  int x0 = u0 * TILE_SIZE, x1 = min((u1 + 1) * TILE_SIZE, board->cols);
+  int y0 = t0 * TILE_SIZE, y1 = min((t1 + 1) * TILE_SIZE, board->lines);
+  while (!any_active(board, y0, y0 + 1, x0, x1)) {
+    y0++;
+  }
+  while (!any_active(board, y1 - 1, y1, x0, x1)) {
+    y1--;
+  }
+  while (!any_active(board, y0, y1, x0, x0 + 1)) {
+    x0++;
+  }
+  while (!any_active(board, y0, y1, x1 - 1, x1)) {
+    x1--;
+  }
+
+  *rect = (golc_rect){.y = y0, .x = x0, .lines = y1 - y0, .cols = x1 - x0};
+  return true;
+}
+
+golc_status golc_get_rect(const golc_board *handle, golc_rect rect,
+                          uint8_t *out, size_t stride) {
+  struct board *board = (struct board *)&handle->board;
+  if (!rect_in_board(board, rect) || stride < (size_t)rect.cols) {
+    return GOLC_EINVAL;
+  }
+  for (int i = 0; i < rect.lines; i++) {
+    memcpy(out + (i * stride), get_cell(board, rect.y + i, rect.x), rect.cols);
+  }
+  return GOLC_OK;
+}
+
+golc_status golc_set_rect(golc_board *handle, golc_rect rect,
+                          const uint8_t *in, size_t stride) {
+  struct board *board = &handle->board;
+  if (!rect_in_board(board, rect) || stride < (size_t)rect.cols) {
+    return GOLC_EINVAL;
+  }
+  // Only the cells which change are flipped, keeping tile populations exact
+  //  without recounting the board
+  for (int i = 0; i < rect.lines; i++) {
+    const uint8_t *row = in + (i * stride);
+    uint8_t *cells = get_cell(board, rect.y + i, rect.x);
+    for (int j = 0; j < rect.cols; j++) {
+      if (!row[j] != !cells[j]) {
+        flip_by_cords(board, rect.y + i, rect.x + j);
+      }
+    }
+  }
+  return GOLC_OK;
+}
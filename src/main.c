@@ -1,4 +1,5 @@
 #include <errno.h>
+#include <signal.h>
 #include <string.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -11,19 +12,74 @@
 /// Buf size max for bottom-line message
 #define MSG_BUF_LEN 512
 
-/// Main curses loop handling all IO
-enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
-  enum error_codes ec = E_SUCCESS;
-
-  int lines = LINES, cols = COLS;
+/// Upper bound on generations computed per displayed frame
+#define MAX_STEPS_PER_FRAME 1000
+
+/// Frames rewound by 'U'
+#define REWIND_LONG 10
+
+/// Iterate the board, across the domain's workers if there is one, recording
+///  the state it came from in the history
+///
+/// The domain's board is gathered every time, each frame is drawn and the
+///  history's keyframes read the whole board
+enum error_codes advance(struct board *board, struct domain *domain,
+                         struct history *history, struct flip_set *flips,
+                         long steps) {
+  long generation = board->generation;
+  struct flip_set *wanted = history->pool ? flips : NULL;
+  enum error_codes ec = domain ? domain_step(domain, board, steps, wanted)
+                               : iterate(board, steps, wanted);
+  if (domain && domain_gather(domain) != E_SUCCESS) {
+    ec = E_IO;
+  }
+  if (ec == E_SUCCESS) {
+    history_push(history, board, generation, flips);
+  } else {
+    history_clear(history);
+  }
+  return ec;
+}
 
-  int scr_width = lines * cols;
-  if (scr == NULL) {
-    scr = malloc(scr_width * sizeof(wchar_t));
-    wmemset(scr, args->inactive, scr_width);
+/// Describe the pages backing the board's cells, their size and which nodes
+///  they lie on
+void describe_pages(struct board *board, char *buf, size_t len) {
+  struct page_report report;
+  page_report(board->cells, (size_t)board->lines * board->cols, &report);
+
+  int n = 0;
+  // The mapping holding the cells may be merged with neighbouring buffers,
+  //  its huge pages can outnumber those of the cells
+  if (report.huge_bytes) {
+    size_t percent = (report.huge_bytes * 100) / report.size;
+    n = snprintf(buf, len, "%zu%% transparent huge pages",
+                 percent < 100 ? percent : 100);
+  } else {
+    n = snprintf(buf, len, "%zu kB pages", report.page_size >> 10);
+  }
+  if (report.samples <= 0) {
+    snprintf(buf + n, len - n, ", node unknown");
+    return;
   }
+  for (int node = 0; node < REPORT_NODES && (size_t)n < len; node++) {
+    if (report.node_pages[node]) {
+      n += snprintf(buf + n, len - n, ", node %d %d%%", node,
+                    (report.node_pages[node] * 100) / report.samples);
+    }
+  }
+}
 
-  wchar_t *scr_bak = NULL;
+/// Main curses loop handling all IO, `pages` describing the pages backing
+///  the board for the first message
+enum error_codes main_loop(struct parsed_args *args, struct board *board,
+                           struct domain *domain, const char *pages) {
+  enum error_codes ec = E_SUCCESS;
+
+  struct board board_bak = {.cells = NULL};
+
+  struct history history;
+  struct flip_set flips = {.idx = NULL};
+  bool history_failed = history_init(&history, args->history_mb) != E_SUCCESS;
 
   refresh();
 
@@ -35,9 +91,17 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
   struct timeval start, end;
   gettimeofday(&start, 0);
 
-  long interval_ms = 200;
+  long interval_ms = args->interval_ms;
+  // A frame always computes at least one generation, a frame of none would
+  //  only push empty records out through the history
+  long steps_per_frame = args->steps < MAX_STEPS_PER_FRAME
+                             ? args->steps
+                             : MAX_STEPS_PER_FRAME;
+  if (steps_per_frame < 1) {
+    steps_per_frame = 1;
+  }
 
-  draw_full_scr(scr);
+  draw_full_scr(board, args);
 
   for (;;) {
     int c = wgetch(stdscr);
@@ -49,7 +113,7 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
 
     /// Write state to file indicated by `-i` or `-o`
     if (c == 'w') {
-      ec = write_scr_to_file(args, scr, lines, cols);
+      ec = write_scr_to_file(args, board);
       if (ec == E_SUCCESS) {
         continue;
       } else {
@@ -62,7 +126,8 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
     case ERR:
       /// No key pressed, do nothing
       if (begin) {
-        snprintf(msg_buf, MSG_BUF_LEN, "Awaiting input...");
+        snprintf(msg_buf, MSG_BUF_LEN, "Awaiting input%s, board on %s...",
+                 history_failed ? ", could not allocate history" : "", pages);
         begin = false;
       }
       break;
@@ -72,13 +137,14 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
       /// Show "help" in message buffer ('k' for 'keys')
       snprintf(msg_buf, MSG_BUF_LEN,
                "[r] run, [b] backup, [R] restore, [i] iterate, [w] write, [s] "
-               "speed, [S] slow");
+               "speed, [S] slow, [a] more steps, [A] fewer steps, [m] render "
+               "mode, [z] zoom out, [Z] zoom in, [arrows] pan, [u] rewind, [U] "
+               "rewind further");
       break;
 
     case 'b':
       /// Make backup of current screen which can be restored using 'R'
-      make_backup(&scr_bak, scr);
-      if (scr_bak == NULL) {
+      if (make_backup(&board_bak, board) != E_SUCCESS) {
         snprintf(msg_buf, MSG_BUF_LEN, "Backup creation failed");
       } else {
         snprintf(msg_buf, MSG_BUF_LEN, "Screen has been backed up");
@@ -88,9 +154,12 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
     case 'r':
       /// Toggle running state
       ///   If the system is not running, a backup is made
+      if (!running && domain && domain->failed) {
+        snprintf(msg_buf, MSG_BUF_LEN, "Cannot run, a worker process has died");
+        break;
+      }
       if (!running) {
-        make_backup(&scr_bak, scr);
-        if (scr_bak == NULL) {
+        if (make_backup(&board_bak, board) != E_SUCCESS) {
           snprintf(msg_buf, MSG_BUF_LEN, "Running, backup creation failed");
         } else {
           snprintf(msg_buf, MSG_BUF_LEN, "Running, screen has been backed up");
@@ -106,22 +175,15 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
       if (running) {
         running = false;
       }
-      // Check that the screen hasn't been resized
-      if (scr_bak) {
-        if (lines * cols == LINES * COLS) {
-          if (scr) {
-            free(scr);
-          }
-          scr = scr_bak;
-          scr_bak = NULL;
-          make_backup(&scr_bak, scr);
-          draw_full_scr(scr);
-          snprintf(msg_buf, MSG_BUF_LEN, "Screen size unchanged, state reset");
-        } else {
-          free(scr_bak);
-          snprintf(msg_buf, MSG_BUF_LEN,
-                   "Screen has been resized since last state save");
+      // The board's dimensions are fixed, so a backup always fits
+      if (board_bak.cells) {
+        make_backup(board, &board_bak);
+        if (domain) {
+          domain_scatter(domain);
         }
+        history_clear(&history);
+        draw_full_scr(board, args);
+        snprintf(msg_buf, MSG_BUF_LEN, "State reset");
       } else {
         snprintf(msg_buf, MSG_BUF_LEN, "No state to restore to");
       }
@@ -131,11 +193,45 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
       /// Perform a single iteration when not running
       if (running) {
         snprintf(msg_buf, MSG_BUF_LEN, "Cannot iterate while running");
+      } else if (domain && domain->failed) {
+        snprintf(msg_buf, MSG_BUF_LEN,
+                 "Cannot iterate, a worker process has died");
+      } else {
+        bool stepped =
+            advance(board, domain, &history, &flips, 1) == E_SUCCESS;
+        draw_full_scr(board, args);
+        if (domain && domain->failed) {
+          snprintf(msg_buf, MSG_BUF_LEN, "A worker process has died");
+        } else if (!stepped) {
+          snprintf(msg_buf, MSG_BUF_LEN,
+                   "Failed to allocate iteration buffers");
+        } else if (history.pool && !history.count) {
+          snprintf(msg_buf, MSG_BUF_LEN,
+                   "Frame too large to record, history cleared");
+        }
+      }
+      break;
+
+    case 'u':
+    case 'U': {
+      /// Rewind to a previous frame, stopping the system if running
+      running = false;
+      int rewound =
+          history_rewind(&history, board, c == 'u' ? 1 : REWIND_LONG);
+      if (rewound) {
+        if (domain) {
+          domain_scatter(domain);
+        }
+        draw_full_scr(board, args);
+        snprintf(msg_buf, MSG_BUF_LEN,
+                 "Rewound to generation %ld, %d more step%s available",
+                 board->generation, history.count,
+                 history.count == 1 ? "" : "s");
       } else {
-        iterate(scr, args);
-        draw_full_scr(scr);
+        snprintf(msg_buf, MSG_BUF_LEN, "No history to rewind to");
       }
       break;
+    }
 
     case 's':
       /// Decrease interval between iterations effectively speeding up
@@ -154,27 +250,28 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
       snprintf(msg_buf, MSG_BUF_LEN, "Interval increased to %ld", interval_ms);
       break;
 
-    case KEY_RESIZE: {
-      /// The terminal has been resized
-      ///  - `scr` must be resized while trying to maintain state
-      ///  - `lines` and `cols` must be reassigned
-      ///  - The whole screen must be redrawn
-      if (running) {
-        snprintf(msg_buf, MSG_BUF_LEN,
-                 "Screen resize while running, results may vary...");
+    case 'a':
+      /// Increase the generations computed between redraws by a factor of ten
+      if (steps_per_frame * 10 <= MAX_STEPS_PER_FRAME) {
+        steps_per_frame *= 10;
+        snprintf(msg_buf, MSG_BUF_LEN, "Steps per frame increased to %ld",
+                 steps_per_frame);
+      } else {
+        snprintf(msg_buf, MSG_BUF_LEN, "Steps per frame cannot be increased");
       }
-      endwin();
-      init_screen();
-      wchar_t *new_scr = resize(scr, args, lines, cols);
-      lines = LINES, cols = COLS;
-      scr_width = lines * cols;
-      if (scr) {
-        free(scr);
+      break;
+
+    case 'A':
+      /// Decrease the generations computed between redraws by a factor of ten,
+      ///  never below one, e.g. from `--steps 5`
+      if (steps_per_frame > 1) {
+        steps_per_frame = steps_per_frame > 10 ? steps_per_frame / 10 : 1;
+        snprintf(msg_buf, MSG_BUF_LEN, "Steps per frame reduced to %ld",
+                 steps_per_frame);
+      } else {
+        snprintf(msg_buf, MSG_BUF_LEN, "Steps per frame cannot be reduced");
       }
-      scr = new_scr;
-      draw_full_scr(scr);
       break;
-    }
 
     case KEY_MOUSE: {
       /// A mouse event has taken place
@@ -188,25 +285,51 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
         break;
       }
       if (e.bstate == BUTTON1_PRESSED) {
+        if (args->zoom) {
+          snprintf(msg_buf, MSG_BUF_LEN, "Cannot edit cells while zoomed out");
+          break;
+        }
         if (running) {
           // A single active box immediately inactivates, so stopping the thing
           //  running makes sense
           running = false;
         }
-        flip_by_cords(scr, args, e.y, e.x);
-        move(e.y, e.x);
-        addnwstr(get_cell(scr, e.y, e.x), 1);
-        int neighbours = count_neighbours(scr, args, e.y, e.x);
+        // In the packed render modes, the top-left cell of the character's
+        //  block is the one flipped
+        int dy, dx;
+        render_density(args->render_mode, &dy, &dx);
+        int y = args->view_y + (e.y * dy), x = args->view_x + (e.x * dx);
+        if (y >= board->lines || x >= board->cols) {
+          snprintf(msg_buf, MSG_BUF_LEN, "Cell [%d, %d] is outside the board",
+                   y, x);
+          break;
+        }
+        flip_by_cords(board, y, x);
+        if (domain) {
+          domain_scatter(domain);
+        }
+        flips.len = 0;
+        if (flip_set_push(&flips, ((size_t)y * board->cols) + x) ==
+            E_SUCCESS) {
+          history_push(&history, board, board->generation, &flips);
+        } else {
+          history_clear(&history);
+        }
+        draw_char(board, args, e.y, e.x);
+        int neighbours = count_neighbours(board, y, x);
         snprintf(msg_buf, MSG_BUF_LEN,
-                 "Cell [%d, %d, (0x%04x)] with %d neighbour%c", e.y, e.x,
-                 e.bstate, neighbours, neighbours == 1 ? ' ' : 's');
+                 "Cell [%d, %d, (0x%04x)] with %d neighbour%c", y, x, e.bstate,
+                 neighbours, neighbours == 1 ? ' ' : 's');
       }
       break;
     }
 
     default:
-      /// Unknown key has been pressed, not really an issue for us
-      snprintf(msg_buf, MSG_BUF_LEN, "Unknown key '%s' (%d)", keyname(c), c);
+      /// Keys moving the view are shared with the viewer, anything else is an
+      ///  unknown key, not really an issue for us
+      if (!view_key(board, args, c, msg_buf, MSG_BUF_LEN)) {
+        snprintf(msg_buf, MSG_BUF_LEN, "Unknown key '%s' (%d)", keyname(c), c);
+      }
     }
 
     // Redraw the message buffer on *every* iteration
@@ -217,8 +340,21 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
     if (running) {
       gettimeofday(&end, 0);
       if (diff_ms(start, end) > interval_ms) {
-        iterate(scr, args);
-        draw_full_scr(scr);
+        bool stepped = advance(board, domain, &history, &flips,
+                               steps_per_frame) == E_SUCCESS;
+        if (domain && domain->failed) {
+          snprintf(msg_buf, MSG_BUF_LEN,
+                   "A worker process has died, stopped running");
+          running = false;
+        } else if (!stepped) {
+          snprintf(msg_buf, MSG_BUF_LEN,
+                   "Failed to allocate iteration buffers");
+          running = false;
+        } else if (history.pool && !history.count) {
+          snprintf(msg_buf, MSG_BUF_LEN,
+                   "Frame too large to record, history cleared");
+        }
+        draw_full_scr(board, args);
         start = end;
       }
     }
@@ -227,14 +363,81 @@ enum error_codes main_loop(struct parsed_args *args, wchar_t *scr) {
     usleep(REFRESH_RATE_US);
   }
 
-  if (scr) {
-    free(scr);
+  board_free(&board_bak);
+  history_free(&history);
+  flip_set_free(&flips);
+
+  return ec;
+}
+
+/// Set by SIGINT and SIGTERM to stop a headless run
+static volatile sig_atomic_t stopping = 0;
+
+static void stop_serving(int sig) {
+  (void)sig;
+  stopping = 1;
+}
+
+/// Loop without a terminal, running the board and publishing every frame to
+///  the viewers of `args->serve` until interrupted
+enum error_codes headless_loop(struct parsed_args *args, struct board *board,
+                               struct domain *domain) {
+  struct stream_server server;
+  enum error_codes ec = stream_listen(&server, args->serve);
+  if (ec == E_OPTION) {
+    fprintf(stderr, "Invalid stream address (%s)\n", args->serve);
+    return ec;
+  } else if (ec != E_SUCCESS) {
+    fprintf(stderr, "Could not listen on '%s' (%d)\n", args->serve, errno);
+    return ec;
   }
+  printf("Serving frames on '%s'\n", args->serve);
+  fflush(stdout);
+
+  signal(SIGINT, stop_serving);
+  signal(SIGTERM, stop_serving);
+
+  struct flip_set flips = {.idx = NULL};
+  struct timeval start, end;
+  gettimeofday(&start, 0);
+
+  while (!stopping) {
+    // Viewers are accepted between generations too, so that they need not wait
+    //  for the next one
+    stream_accept(&server);
+    gettimeofday(&end, 0);
+    if (diff_ms(start, end) > args->interval_ms) {
+      ec = domain ? domain_step(domain, board, args->steps, &flips)
+                  : iterate(board, args->steps, &flips);
+      // Any viewer may be sent a keyframe, which reads the whole board
+      if (domain && server.n_clients) {
+        domain_gather(domain);
+      }
+      if (domain && domain->failed) {
+        fprintf(stderr, "A worker process has died\n");
+        break;
+      }
+      // Without the flips, e.g. when they could not be allocated, every viewer
+      //  needs a keyframe
+      stream_publish(&server, board, ec == E_SUCCESS ? &flips : NULL);
+      ec = E_SUCCESS;
+      start = end;
+    } else if (!domain || !stream_wants_keyframe(&server) ||
+               domain_gather(domain) == E_SUCCESS) {
+      // Between generations only stale viewers are sent anything, a domain's
+      //  board being gathered just when one of them can take a keyframe
+      stream_catch_up(&server, board);
+    } else {
+      stream_flush(&server);
+    }
 
-  if (scr_bak) {
-    free(scr_bak);
+    // Sleep for a short period to avoid CPU overuse
+    usleep(REFRESH_RATE_US);
   }
 
+  stream_close(&server);
+  flip_set_free(&flips);
+
   return ec;
 }
 
@@ -289,32 +492,111 @@ int main(int argc, char **argv) {
   }
   fclose(outf);
 
-  struct InfileData infile_data = {.scr = NULL};
+  struct InfileData infile_data = {.cells = NULL};
   if (args.infile) {
-    if (read_scr_from_file(&args, &infile_data) == E_IO) {
+    enum error_codes ec = read_scr_from_file(&args, &infile_data);
+    if (ec != E_SUCCESS) {
       fprintf(stderr, "Failed to read infile (%s) to screen buffer\n",
               args.infile);
-      return E_IO;
-    };
+      return ec;
+    }
   }
 
-  if (init_screen() == E_CURSES) {
+  // The board takes its size from the infile unless given one, so that none
+  //  of the infile is cropped away, the view pans over whatever the terminal
+  //  cannot show
+  int board_lines = args.board_lines, board_cols = args.board_cols;
+  if (!board_lines && args.infile) {
+    board_lines = infile_data.lines, board_cols = infile_data.cols;
+  }
+  if (args.serve && !board_lines) {
+    fprintf(stderr, "Serving needs a board size or an infile\n");
+    return E_OPTION;
+  }
+
+  if (!args.serve && init_screen() == E_CURSES) {
     fprintf(stderr, "Error when initializing screen\n");
     return E_CURSES;
   }
 
-  wchar_t *scr = NULL;
+  // Without a size or an infile, the board fills the initial terminal at the
+  //  density of the initial render mode, it keeps these dimensions for the
+  //  whole run regardless of later terminal resizes
+  if (!board_lines) {
+    int dy, dx;
+    render_density(args.render_mode, &dy, &dx);
+    board_lines = (LINES - 1) * dy, board_cols = COLS * dx;
+  }
+
+  struct page_allocator pages;
+  page_allocator_init(&pages, args.pages);
+
+  struct board board;
+  if (board_init(&board, board_lines, board_cols, args.wrapping,
+                 &pages.alloc) != E_SUCCESS) {
+    if (!args.serve) {
+      endwin();
+    }
+    fprintf(stderr, "Failed to allocate board of dimensions [%d, %d]\n",
+            board_lines, board_cols);
+    free(infile_data.cells);
+    return E_ALLOC;
+  }
+
+  board.rule = args.rule;
+
+  // Before the board is filled, so that each thread's rows are placed by it
+  if (board_set_threads(&board, args.threads) != E_SUCCESS) {
+    if (!args.serve) {
+      endwin();
+    }
+    fprintf(stderr, "Failed to start %d threads\n", args.threads);
+    free(infile_data.cells);
+    board_free(&board);
+    return E_ALLOC;
+  }
 
   if (args.infile) {
-    scr = resize(infile_data.scr, &args, infile_data.lines, infile_data.cols);
-    if (infile_data.scr) {
-      free(infile_data.scr);
+    blit_cells(&board, infile_data.cells, infile_data.lines, infile_data.cols);
+    if (infile_data.cells) {
+      free(infile_data.cells);
+    }
+  }
+
+  // Described before a domain can move the cells into memory of its own
+  char placement[MSG_BUF_LEN / 2];
+  describe_pages(&board, placement, sizeof(placement));
+  if (args.serve) {
+    printf("Board of [%d, %d] on %s\n", board.lines, board.cols, placement);
+  }
+
+  struct domain domain;
+  if (args.processes > 1) {
+    enum error_codes ec = domain_init(&domain, &board, args.processes);
+    if (ec != E_SUCCESS) {
+      if (!args.serve) {
+        endwin();
+      }
+      fprintf(stderr, "Failed to split board between %d processes\n",
+              args.processes);
+      board_free(&board);
+      return ec;
     }
   }
 
-  enum error_codes ec = main_loop(&args, scr);
+  enum error_codes ec;
+  if (args.serve) {
+    ec = headless_loop(&args, &board, args.processes > 1 ? &domain : NULL);
+  } else {
+    ec = main_loop(&args, &board, args.processes > 1 ? &domain : NULL,
+                   placement);
+    endwin();
+  }
 
-  endwin();
+  if (args.processes > 1) {
+    domain_free(&domain);
+  }
+  board_free(&board);
 
   return ec;
 }
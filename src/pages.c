@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "engine.h"
+
+/// Huge page size assumed when `/proc/meminfo` does not give one
+#define DEFAULT_HUGE_SIZE ((size_t)2 << 20)
+
+/// Upper bound on the pages sampled when reporting node placement
+#define NODE_SAMPLES 1024
+
+static size_t round_up(size_t size, size_t to) {
+  return ((size + to - 1) / to) * to;
+}
+
+/// Map `len` bytes aligned to a huge page, over-mapping by one so that the
+///  unaligned ends can be trimmed off, huge pages only back aligned ranges
+static void *map_aligned(size_t len, size_t huge_size) {
+  uint8_t *raw = mmap(NULL, len + huge_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return NULL;
+  }
+  uint8_t *ptr = (uint8_t *)round_up((uintptr_t)raw, huge_size);
+  if (ptr > raw) {
+    munmap(raw, ptr - raw);
+  }
+  size_t tail = (raw + len + huge_size) - (ptr + len);
+  if (tail) {
+    munmap(ptr + len, tail);
+  }
+  return ptr;
+}
+
+/// Buffers smaller than a huge page come from `calloc`, anything larger is
+///  mapped and rounded up to whole huge pages
+static void *page_alloc(size_t size, void *ctx) {
+  struct page_allocator *pages = ctx;
+  if (size < pages->huge_size) {
+    return calloc(1, size);
+  }
+  size_t len = round_up(size, pages->huge_size);
+
+  if (pages->policy == PAGES_EXPLICIT) {
+    void *ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      return ptr;
+    }
+  }
+
+  void *ptr = map_aligned(len, pages->huge_size);
+  if (ptr && pages->policy != PAGES_NORMAL) {
+    // Only advice, the kernel may still refuse or have THP disabled
+    madvise(ptr, len, MADV_HUGEPAGE);
+  }
+  return ptr;
+}
+
+static void page_free(void *ptr, size_t size, void *ctx) {
+  struct page_allocator *pages = ctx;
+  if (size < pages->huge_size) {
+    free(ptr);
+  } else {
+    munmap(ptr, round_up(size, pages->huge_size));
+  }
+}
+
+/// Read a "<key>: <n> kB" field from a `/proc` file, 0 if it is not found
+static size_t read_kb_field(FILE *fp, const char *key) {
+  char line[256];
+  size_t key_len = strlen(key);
+  while (fgets(line, sizeof(line), fp)) {
+    size_t kb;
+    if (!strncmp(line, key, key_len) && line[key_len] == ':' &&
+        sscanf(line + key_len + 1, "%zu", &kb) == 1) {
+      return kb;
+    }
+  }
+  return 0;
+}
+
+/// Set up an allocator for the given policy, the huge page size being that of
+///  the system's default huge pages
+void page_allocator_init(struct page_allocator *pages,
+                         enum page_policy policy) {
+  pages->policy = policy;
+  pages->huge_size = DEFAULT_HUGE_SIZE;
+  FILE *fp = fopen("/proc/meminfo", "r");
+  if (fp) {
+    size_t kb = read_kb_field(fp, "Hugepagesize");
+    if (kb) {
+      pages->huge_size = kb << 10;
+    }
+    fclose(fp);
+  }
+  pages->alloc = (struct allocator){
+      .alloc = page_alloc,
+      .free = page_free,
+      .ctx = pages,
+      .zeroed = true,
+  };
+}
+
+/// Find the page size and transparent huge page usage of the mapping holding
+///  `ptr` in `/proc/self/smaps`
+static void report_mapping(const void *ptr, struct page_report *report) {
+  FILE *fp = fopen("/proc/self/smaps", "r");
+  if (!fp) {
+    return;
+  }
+  char line[256];
+  bool found = false;
+  while (!found && fgets(line, sizeof(line), fp)) {
+    uintptr_t start, end;
+    found = sscanf(line, "%lx-%lx ", &start, &end) == 2 &&
+            (uintptr_t)ptr >= start && (uintptr_t)ptr < end;
+  }
+  if (found) {
+    // Fields of a mapping come in a fixed order, the page size before the
+    //  transparent huge pages
+    size_t kb = read_kb_field(fp, "KernelPageSize");
+    if (kb) {
+      report->page_size = kb << 10;
+    }
+    report->huge_bytes = read_kb_field(fp, "AnonHugePages") << 10;
+  }
+  fclose(fp);
+}
+
+/// Describe the pages backing the `size` bytes at `ptr`, sampling pages
+///  across the buffer for the node each lies on
+///
+/// Pages never touched belong to no node and are not counted
+void page_report(const void *ptr, size_t size, struct page_report *report) {
+  memset(report, 0, sizeof(struct page_report));
+  report->size = size;
+  size_t page = sysconf(_SC_PAGESIZE);
+  report->page_size = page;
+  report_mapping(ptr, report);
+
+  size_t n_pages = (size + page - 1) / page;
+  unsigned long count = n_pages < NODE_SAMPLES ? n_pages : NODE_SAMPLES;
+  void **addrs = malloc(count * sizeof(void *));
+  int *status = malloc(count * sizeof(int));
+  if (!addrs || !status || !count) {
+    report->samples = -1;
+    free(addrs);
+    free(status);
+    return;
+  }
+  for (unsigned long i = 0; i < count; i++) {
+    uintptr_t addr = (uintptr_t)ptr + (size_t)((i * n_pages) / count) * page;
+    addrs[i] = (void *)(addr - (addr % page));
+  }
+
+  // Without target nodes `move_pages` only queries where each page lies
+  if (syscall(SYS_move_pages, 0, count, addrs, NULL, status, 0) != 0) {
+    report->samples = -1;
+  } else {
+    for (unsigned long i = 0; i < count; i++) {
+      if (status[i] >= 0) {
+        report->samples++;
+        report->node_pages[min(status[i], REPORT_NODES - 1)]++;
+      }
+    }
+  }
+  free(addrs);
+  free(status);
+}
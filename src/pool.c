@@ -0,0 +1,95 @@
+#include "engine.h"
+
+struct pool_thread {
+  struct band_pool *pool;
+  int index;
+};
+
+/// Body of every thread but the caller's, running each job given to the pool
+///  until given none
+static void *pool_thread(void *arg) {
+  struct pool_thread thread = *(struct pool_thread *)arg;
+  struct band_pool *pool = thread.pool;
+  free(arg);
+
+  // Held by `pool_init` until it knows how many threads made it
+  pthread_mutex_lock(&pool->gate);
+  pthread_mutex_unlock(&pool->gate);
+
+  for (;;) {
+    pthread_barrier_wait(&pool->start);
+    if (!pool->job) {
+      break;
+    }
+    pool->job(pool->arg, thread.index);
+    pthread_barrier_wait(&pool->done);
+  }
+  return NULL;
+}
+
+/// Start a pool of `threads` threads, the calling thread being the first of
+///  them
+///
+/// If not every thread can be started the pool carries on with those that
+///  were, `pool->threads` says how many that is
+enum error_codes pool_init(struct band_pool *pool, int threads) {
+  memset(pool, 0, sizeof(struct band_pool));
+  pool->ids = calloc(threads, sizeof(pthread_t));
+  if (!pool->ids) {
+    return E_ALLOC;
+  }
+  pthread_mutex_init(&pool->gate, NULL);
+  pthread_mutex_lock(&pool->gate);
+
+  pool->threads = 1;
+  for (int t = 1; t < threads; t++) {
+    struct pool_thread *arg = malloc(sizeof(struct pool_thread));
+    if (!arg) {
+      break;
+    }
+    *arg = (struct pool_thread){.pool = pool, .index = t};
+    if (pthread_create(pool->ids + t, NULL, pool_thread, arg) != 0) {
+      free(arg);
+      break;
+    }
+    pool->threads++;
+  }
+
+  pthread_barrier_init(&pool->start, NULL, pool->threads);
+  pthread_barrier_init(&pool->done, NULL, pool->threads);
+  pthread_barrier_init(&pool->sync, NULL, pool->threads);
+  pthread_mutex_unlock(&pool->gate);
+  return E_SUCCESS;
+}
+
+/// Run `job` on every thread of the pool, returning once all have finished
+///  - `job` is given `arg` and the index of the thread running it
+void pool_run(struct band_pool *pool, void (*job)(void *, int), void *arg) {
+  pool->job = job;
+  pool->arg = arg;
+  pthread_barrier_wait(&pool->start);
+  job(arg, 0);
+  pthread_barrier_wait(&pool->done);
+}
+
+/// Wait, from within a job, for every thread of the pool to reach this point
+void pool_sync(struct band_pool *pool) {
+  pthread_barrier_wait(&pool->sync);
+}
+
+void pool_free(struct band_pool *pool) {
+  if (!pool->ids) {
+    return;
+  }
+  pool->job = NULL;
+  pthread_barrier_wait(&pool->start);
+  for (int t = 1; t < pool->threads; t++) {
+    pthread_join(pool->ids[t], NULL);
+  }
+  pthread_barrier_destroy(&pool->start);
+  pthread_barrier_destroy(&pool->done);
+  pthread_barrier_destroy(&pool->sync);
+  pthread_mutex_destroy(&pool->gate);
+  free(pool->ids);
+  memset(pool, 0, sizeof(struct band_pool));
+}
@@ -1,5 +1,9 @@
 #include "golc.h"
 
+/// Upper bound on the cells summarised, vertically and horizontally, by each
+///  character when zoomed out
+#define MAX_ZOOM 1024
+
 /// Initialize the ncurses screen, enables:
 ///  - Wide-character input
 ///  - Non-blocking input (`getch`, screen resize, etc.)
@@ -33,119 +37,150 @@ enum error_codes init_screen() {
   return E_SUCCESS;
 }
 
-/// Upon a terminal resize event, resize the screen buffer. This should be a
-///  simple enough process, but keeping the state of the original buffer within
-///  the new buffer added a little complexity
-///
-/// Here, we are copying `min(old_cols, new_cols)` from the line offset of
-/// `old_screen` into the line in `new_screen`
-wchar_t *resize(wchar_t *old_scr, struct parsed_args *args, int old_lines,
-                int old_cols) {
-  int new_scr_width = LINES * COLS;
-  wchar_t *new_scr = malloc(new_scr_width * sizeof(wchar_t));
-  wmemset(new_scr, args->inactive, new_scr_width);
-  int min_cols = min(old_cols, COLS);
-  for (int i = 0; i < LINES - 1; i++) {
-    if ((i + 1) * old_cols > (old_lines * old_cols) - 1 ||
-        (i + 1) * COLS > new_scr_width - 1) {
-      printf("[resize] Out of space in new arr (%d/%d)\n", i, old_lines);
-      break;
-    }
-    wcsncpy(new_scr + (i * COLS), old_scr + (i * old_cols), min_cols);
+/// Glyphs for a 1x2 block of cells, indexed by `top | bottom << 1`, the empty
+///  block is drawn with the inactive character
+static const wchar_t HALF_GLYPHS[4] = {0, u'▀', u'▄', u'█'};
+
+/// Braille dot bits for a pair of horizontally adjacent cells, indexed by row
+///  of the 2x4 block and then `left | right << 1`
+static const uint8_t BRAILLE_DOTS[4][4] = {
+    {0x00, 0x01, 0x08, 0x09},
+    {0x00, 0x02, 0x10, 0x12},
+    {0x00, 0x04, 0x20, 0x24},
+    {0x00, 0x40, 0x80, 0xc0},
+};
+
+#define BRAILLE_BASE 0x2800
+
+/// Shades for the zoomed out view, from empty to fully populated, the empty
+///  shade is drawn with the inactive character
+static const wchar_t DENSITY_SHADES[] = {0, u'░', u'▒', u'▓', u'█'};
+
+#define DENSITY_LEVELS (sizeof(DENSITY_SHADES) / sizeof(DENSITY_SHADES[0]))
+
+/// The number of board cells, vertically and horizontally, packed into a
+///  single terminal character by the given render mode
+void render_density(enum render_mode mode, int *dy, int *dx) {
+  switch (mode) {
+  case RENDER_HALF:
+    *dy = 2, *dx = 1;
+    break;
+  case RENDER_BRAILLE:
+    *dy = 4, *dx = 2;
+    break;
+  default:
+    *dy = 1, *dx = 1;
   }
-  return new_scr;
 }
 
-/// Iterate the screen buffer once by the game of life rules
-///  - Active cells with 1,4..8 neighbours become inactive
-///  - Inactive cells with 3 neighbours become active
-void iterate(wchar_t *scr, struct parsed_args *args) {
-  int scr_width = (LINES - 1) * COLS;
-  // We don't want modifications to the original buffer until we know how the
-  //  whole buffer must change, ergo store the values which must be flipped in a
-  //  new buffer
-  wchar_t **flip_arr = calloc(scr_width, sizeof(wchar_t));
-  int flip_idx = 0;
-  for (int y = 0; y < LINES - 1; y++) {
-    for (int x = 0; x < COLS; x++) {
-      int neighbours = count_neighbours(scr, args, y, x);
-      wchar_t *cell = get_cell(scr, y, x);
-      bool active = cell_is_active(cell, args);
-      if (active) {
-        if (neighbours < 2 || neighbours > 3) {
-          flip_arr[flip_idx] = cell;
-          flip_idx++;
-        }
-      } else if (neighbours == 3) {
-        flip_arr[flip_idx] = cell;
-        flip_idx++;
+/// Fill `line_buf` with `width` characters of the zoomed out terminal line
+///  `y`, each summarising a `zoom` square block of cells
+///
+/// Each block is aggregated from the engine's tile populations rather than
+///  from the cells themselves, so the cost of a frame scales with the number of
+///  tiles rather than the number of cells
+static void render_zoom_line(struct board *board, struct parsed_args *args,
+                             wchar_t *line_buf, int y, int x0, int width) {
+  // Blocks are aligned to the tile containing the view's origin
+  int zoom = args->zoom, per_tile = zoom / TILE_SIZE;
+  int t = (args->view_y / TILE_SIZE) + (y * per_tile);
+  int block_lines = min(board->lines - (t * TILE_SIZE), zoom);
+  for (int i = 0; i < width; i++) {
+    int u = (args->view_x / TILE_SIZE) + ((x0 + i) * per_tile);
+    int block_cols = min(board->cols - (u * TILE_SIZE), zoom);
+    wchar_t ch = 0;
+    if (block_lines > 0 && block_cols > 0) {
+      uint64_t pop = tile_range_pop(board, t, t + per_tile, u, u + per_tile);
+      if (pop) {
+        // Any population at all is shown with at least the lightest shade
+        uint64_t area = (uint64_t)block_lines * block_cols;
+        size_t level = 1 + (pop * (DENSITY_LEVELS - 1) - 1) / area;
+        ch = DENSITY_SHADES[level];
       }
     }
-  }
-  // Iterate the flip buffer mentioned above and flip the cells referred to by
-  //  each pointer
-  for (int i = 0; i < scr_width; i++) {
-    if (flip_arr[i] == NULL) {
-      break;
-    }
-    flip_by_cell(flip_arr[i], args);
-  }
-  if (flip_arr) {
-    free(flip_arr);
+    line_buf[i] = ch ? ch : args->inactive;
   }
 }
 
-/// Calculate the count of active neighbours surrounding a particular cell
-///  - Despite the game of life existing on an infinite grid, this one wraps...
-int count_neighbours(wchar_t *scr, struct parsed_args *args, int y, int x) {
-  int neighbours = 0;
-  for (int i = -1; i <= 1; i++) {
-    int _y = y + i;
-    if (args->wrapping) {
-      _y = _y % (LINES - 1);
-      if (_y < 0) {
-        _y += LINES - 1;
-      }
-    } else {
-      if (_y < 0 || _y > LINES - 1) {
-        continue;
-      }
+/// Fill `line_buf` with `width` characters of the terminal line `y`, starting
+///  at column `x0`, built straight from the board's cells with the lookup
+///  tables above
+///
+/// Cells beyond the edge of the board are drawn as inactive
+static void render_line(struct board *board, struct parsed_args *args,
+                        wchar_t *line_buf, int y, int x0, int width) {
+  if (args->zoom) {
+    render_zoom_line(board, args, line_buf, y, x0, width);
+    return;
+  }
+  int dy, dx;
+  render_density(args->render_mode, &dy, &dx);
+  for (int i = 0; i < width; i++) {
+    int cy = args->view_y + (y * dy), cx = args->view_x + ((x0 + i) * dx);
+    wchar_t ch = 0;
+    switch (args->render_mode) {
+    case RENDER_HALF: {
+      int idx = cell_is_active(board, cy, cx) |
+                cell_is_active(board, cy + 1, cx) << 1;
+      ch = HALF_GLYPHS[idx];
+      break;
     }
-    for (int j = -1; j <= 1; j++) {
-      // We don't count an active cell as a neighbour of itself
-      if (i == 0 && j == 0) {
-        continue;
-      }
-      // Calculate true x and y coords, wrapping as described above
-      int _x = x + j;
-      if (args->wrapping) {
-        _x = _x % COLS;
-        if (_x < 0) {
-          _x += COLS;
-        }
-      } else {
-        if (_x < 0 || _x > COLS) {
-          continue;
-        }
+    case RENDER_BRAILLE: {
+      uint8_t dots = 0;
+      for (int r = 0; r < 4; r++) {
+        int idx = cell_is_active(board, cy + r, cx) |
+                  cell_is_active(board, cy + r, cx + 1) << 1;
+        dots |= BRAILLE_DOTS[r][idx];
       }
-      // printf("(%d, %d) ", _y, _x);
-      neighbours += cell_is_active(get_cell(scr, _y, _x), args);
+      ch = dots ? BRAILLE_BASE + dots : 0;
+      break;
+    }
+    default:
+      ch = cell_is_active(board, cy, cx) ? args->active : 0;
     }
+    line_buf[i] = ch ? ch : args->inactive;
   }
-  // printf("\n");
-  return neighbours;
 }
 
-/// Draw the entire screen buffer to the terminal, line by line
-void draw_full_scr(const wchar_t *scr) {
+/// The number of board cells, vertically and horizontally, covered by a
+///  single terminal character in the current view
+void view_cells(struct parsed_args *args, int *dy, int *dx) {
+  if (args->zoom) {
+    *dy = args->zoom, *dx = args->zoom;
+  } else {
+    render_density(args->render_mode, dy, dx);
+  }
+}
+
+/// Move the view's origin by the given number of cells, keeping at least one
+///  cell of the board in view
+///
+/// The board itself is never touched, so panning, like resizing the terminal,
+///  costs the same regardless of the size of the board
+void pan_view(struct board *board, struct parsed_args *args, int dy, int dx) {
+  args->view_y = max(0, min(args->view_y + dy, board->lines - 1));
+  args->view_x = max(0, min(args->view_x + dx, board->cols - 1));
+}
+
+/// Draw the view of the board to the terminal, line by line, in the current
+///  render mode
+void draw_full_scr(struct board *board, struct parsed_args *args) {
   wchar_t line_buf[COLS];
   for (int i = 0; i < LINES - 1; i++) {
-    wcsncpy(line_buf, scr + (i * COLS), COLS);
+    render_line(board, args, line_buf, i, 0, COLS);
     move(i, 0);
     addnwstr(line_buf, COLS);
   }
 }
 
+/// Redraw the single terminal character at (y, x)
+void draw_char(struct board *board, struct parsed_args *args, int y, int x) {
+  wchar_t ch;
+  render_line(board, args, &ch, y, x, 1);
+  move(y, x);
+  addnwstr(&ch, 1);
+}
+
 /// Draw the message buffer to the last line of the view
 void draw_msg_buf(char *msg_buf) {
   move(LINES - 1, 0);
@@ -154,29 +189,82 @@ void draw_msg_buf(char *msg_buf) {
   clrtoeol();
 }
 
-bool cell_is_active(wchar_t *cell, struct parsed_args *args) {
-  return *cell == args->active;
-}
+/// Handle a key which only changes how the board is viewed, shared by `golc`
+///  and `golc-view`, returning false for any other key
+bool view_key(struct board *board, struct parsed_args *args, int c,
+              char *msg_buf, size_t len) {
+  switch (c) {
+  case 'm':
+    /// Cycle the number of cells packed into each terminal character
+    args->render_mode = (args->render_mode + 1) % RENDER_MODES;
+    clear();
+    draw_full_scr(board, args);
+    snprintf(msg_buf, len, "Render mode set to %s",
+             RENDER_MODE_NAMES[args->render_mode]);
+    break;
 
-int flip_by_cell(wchar_t *cell, struct parsed_args *args) {
-  if (cell_is_active(cell, args)) {
-    *cell = args->inactive;
-  } else {
-    *cell = args->active;
-  }
-  return *cell;
-}
+  case 'z':
+    /// Zoom out, doubling the block of cells summarised by each character
+    if (!args->zoom || args->zoom * 2 <= MAX_ZOOM) {
+      args->zoom = args->zoom ? args->zoom * 2 : TILE_SIZE;
+      draw_full_scr(board, args);
+      snprintf(msg_buf, len, "Zoomed out to %dx%d cells", args->zoom,
+               args->zoom);
+    } else {
+      snprintf(msg_buf, len, "Cannot zoom out further");
+    }
+    break;
+
+  case 'Z':
+    /// Zoom in, halving the block of cells summarised by each character until
+    ///  the render mode is used again
+    if (args->zoom) {
+      args->zoom = args->zoom > TILE_SIZE ? args->zoom / 2 : 0;
+      draw_full_scr(board, args);
+      if (args->zoom) {
+        snprintf(msg_buf, len, "Zoomed in to %dx%d cells",
+                 args->zoom, args->zoom);
+      } else {
+        snprintf(msg_buf, len, "Zoomed in to %s render mode",
+                 RENDER_MODE_NAMES[args->render_mode]);
+      }
+    } else {
+      snprintf(msg_buf, len, "Cannot zoom in further");
+    }
+    break;
 
-wchar_t *get_cell(wchar_t *scr, int y, int x) { return scr + ((y * COLS) + x); }
+  case KEY_UP:
+  case KEY_DOWN:
+  case KEY_LEFT:
+  case KEY_RIGHT: {
+    /// Pan the view by a quarter of the terminal in the given direction
+    int dy, dx;
+    view_cells(args, &dy, &dx);
+    dy *= max(1, (LINES - 1) / 4);
+    dx *= max(1, COLS / 4);
+    if (c == KEY_UP || c == KEY_DOWN) {
+      pan_view(board, args, c == KEY_UP ? -dy : dy, 0);
+    } else {
+      pan_view(board, args, 0, c == KEY_LEFT ? -dx : dx);
+    }
+    clear();
+    draw_full_scr(board, args);
+    snprintf(msg_buf, len, "Viewing from cell [%d, %d]",
+             args->view_y, args->view_x);
+    break;
+  }
 
-int flip_by_cords(wchar_t *scr, struct parsed_args *args, int y, int x) {
-  return flip_by_cell(get_cell(scr, y, x), args);
-}
+  case KEY_RESIZE:
+    /// The terminal has been resized
+    ///  - The board is independent of the terminal, only the view changes
+    ///  - The whole screen must be redrawn
+    endwin();
+    init_screen();
+    draw_full_scr(board, args);
+    break;
 
-/// Make a backup of scr into scr_bak
-void make_backup(wchar_t **scr_bak, wchar_t *scr) {
-  if (*scr_bak) {
-    free(*scr_bak);
+  default:
+    return false;
   }
-  *scr_bak = wcsdup(scr);
+  return true;
 }
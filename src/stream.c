@@ -0,0 +1,399 @@
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "engine.h"
+
+/// Pending connections queued by the listening socket
+#define LISTEN_BACKLOG 16
+
+/// First bytes of every frame, to catch a viewer connected to something else
+static const uint8_t FRAME_MAGIC[2] = {'G', 'L'};
+
+/// Frame header layout, all integers being little-endian
+///  - [0, 2)   magic
+///  - 2        `enum frame_type`
+///  - 3        reserved
+///  - [4, 8)   lines
+///  - [8, 12)  cols
+///  - [12, 20) generation
+///  - [20, 28) payload length
+static void put_le(uint8_t *out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out[i] = (value >> (8 * i)) & 0xff;
+  }
+}
+
+static uint64_t get_le(const uint8_t *in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value |= (uint64_t)in[i] << (8 * i);
+  }
+  return value;
+}
+
+static void put_header(uint8_t *out, enum frame_type type, struct board *board,
+                       size_t len) {
+  memcpy(out, FRAME_MAGIC, sizeof(FRAME_MAGIC));
+  out[2] = type;
+  out[3] = 0;
+  put_le(out + 4, board->lines, 4);
+  put_le(out + 8, board->cols, 4);
+  put_le(out + 12, board->generation, 8);
+  put_le(out + 20, len, 8);
+}
+
+/// Parse a stream address, a port number being a TCP port on loopback and
+///  anything else the path of a Unix domain socket
+static enum error_codes parse_addr(const char *addr,
+                                   struct sockaddr_storage *sa,
+                                   socklen_t *sa_len) {
+  memset(sa, 0, sizeof(struct sockaddr_storage));
+  bool numeric = *addr != 0;
+  for (const char *c = addr; *c; c++) {
+    numeric = numeric && isdigit((unsigned char)*c);
+  }
+  if (numeric) {
+    int port = atoi(addr);
+    if (port <= 0 || port > 65535) {
+      return E_OPTION;
+    }
+    struct sockaddr_in *in = (struct sockaddr_in *)sa;
+    in->sin_family = AF_INET;
+    in->sin_port = htons(port);
+    in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    *sa_len = sizeof(struct sockaddr_in);
+    return E_SUCCESS;
+  }
+  struct sockaddr_un *un = (struct sockaddr_un *)sa;
+  if (strlen(addr) >= sizeof(un->sun_path)) {
+    return E_OPTION;
+  }
+  un->sun_family = AF_UNIX;
+  strcpy(un->sun_path, addr);
+  *sa_len = sizeof(struct sockaddr_un);
+  return E_SUCCESS;
+}
+
+static void set_nonblocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/// Listen for viewers on `addr`, a stale socket left at a Unix path by an
+///  earlier run is replaced
+///  - E_OPTION if `addr` is not a valid address, E_IO with `errno` set if it
+///    cannot be listened on
+enum error_codes stream_listen(struct stream_server *server, const char *addr) {
+  memset(server, 0, sizeof(struct stream_server));
+  server->fd = -1;
+  struct sockaddr_storage sa;
+  socklen_t sa_len;
+  if (parse_addr(addr, &sa, &sa_len) != E_SUCCESS) {
+    return E_OPTION;
+  }
+
+  if (sa.ss_family == AF_UNIX) {
+    struct stat st;
+    if (stat(addr, &st) == 0 && S_ISSOCK(st.st_mode)) {
+      unlink(addr);
+    }
+  }
+
+  server->fd = socket(sa.ss_family, SOCK_STREAM, 0);
+  if (server->fd == -1) {
+    return E_IO;
+  }
+  int reuse = 1;
+  setsockopt(server->fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (bind(server->fd, (struct sockaddr *)&sa, sa_len) == -1 ||
+      listen(server->fd, LISTEN_BACKLOG) == -1) {
+    int err = errno;
+    close(server->fd);
+    errno = err;
+    server->fd = -1;
+    return E_IO;
+  }
+  if (sa.ss_family == AF_UNIX) {
+    strcpy(server->path, addr);
+  }
+  set_nonblocking(server->fd);
+  return E_SUCCESS;
+}
+
+static void drop_client(struct stream_server *server, int i) {
+  close(server->clients[i].fd);
+  free(server->clients[i].buf);
+  server->clients[i] = server->clients[--server->n_clients];
+}
+
+/// Accept every pending viewer, each starting stale so that its first frame
+///  is a keyframe
+void stream_accept(struct stream_server *server) {
+  int fd;
+  while ((fd = accept(server->fd, NULL, NULL)) != -1) {
+    if (server->n_clients == server->cap_clients) {
+      int cap = server->cap_clients ? server->cap_clients * 2 : 4;
+      struct stream_client *clients =
+          realloc(server->clients, cap * sizeof(struct stream_client));
+      if (!clients) {
+        close(fd);
+        return;
+      }
+      server->clients = clients;
+      server->cap_clients = cap;
+    }
+    set_nonblocking(fd);
+    server->clients[server->n_clients++] =
+        (struct stream_client){.fd = fd, .stale = true};
+  }
+}
+
+/// Send as much of each viewer's frame as its socket takes without blocking,
+///  dropping viewers which have gone away
+void stream_flush(struct stream_server *server) {
+  for (int i = 0; i < server->n_clients;) {
+    struct stream_client *client = server->clients + i;
+    while (client->sent < client->len) {
+      ssize_t n = send(client->fd, client->buf + client->sent,
+                       client->len - client->sent, MSG_NOSIGNAL);
+      if (n <= 0) {
+        break;
+      }
+      client->sent += n;
+    }
+    if (client->sent < client->len && errno != EAGAIN &&
+        errno != EWOULDBLOCK && errno != EINTR) {
+      drop_client(server, i);
+    } else {
+      i++;
+    }
+  }
+}
+
+/// Whether any viewer is waiting on a keyframe which it can be sent now
+bool stream_wants_keyframe(const struct stream_server *server) {
+  for (int i = 0; i < server->n_clients; i++) {
+    const struct stream_client *client = server->clients + i;
+    if (client->stale && client->sent == client->len) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Queue a frame of the board's current generation for each viewer, or only
+///  the stale ones when `stale_only`
+///
+/// Viewers still sending an earlier frame skip this one, rather than holding
+///  up the simulation, and are sent a keyframe of the newest generation once
+///  they have caught up. Each kind of frame is only encoded once, later
+///  viewers copying it from the first
+static void queue_frames(struct stream_server *server, struct board *board,
+                         const struct flip_set *flips, bool stale_only) {
+  size_t keyframe_len = (((size_t)board->lines * board->cols) + 7) / 8;
+  size_t flips_len = flips ? delta_len(flips) : keyframe_len;
+  // As with the history, deltas are never larger than a keyframe
+  bool delta_ok = flips && flips_len < keyframe_len;
+  const uint8_t *encoded[2] = {NULL, NULL};
+
+  for (int i = 0; i < server->n_clients; i++) {
+    struct stream_client *client = server->clients + i;
+    if (stale_only && !client->stale) {
+      continue;
+    }
+    if (client->sent < client->len) {
+      client->stale = true;
+      continue;
+    }
+    bool keyframe = client->stale || !delta_ok;
+    size_t len = FRAME_HEADER_LEN + (keyframe ? keyframe_len : flips_len);
+    if (len > client->cap) {
+      uint8_t *buf = realloc(client->buf, len);
+      if (!buf) {
+        client->stale = true;
+        continue;
+      }
+      client->buf = buf;
+      client->cap = len;
+    }
+
+    if (encoded[keyframe]) {
+      memcpy(client->buf, encoded[keyframe], len);
+    } else {
+      put_header(client->buf, keyframe ? FRAME_KEYFRAME : FRAME_DELTA, board,
+                 len - FRAME_HEADER_LEN);
+      if (keyframe) {
+        struct flip_set none = {.idx = NULL};
+        encode_keyframe(board, &none, client->buf + FRAME_HEADER_LEN);
+      } else {
+        encode_delta(flips, client->buf + FRAME_HEADER_LEN);
+      }
+      encoded[keyframe] = client->buf;
+    }
+    client->len = len;
+    client->sent = 0;
+    client->stale = false;
+  }
+}
+
+/// Publish the board's current generation to every viewer, `flips` being the
+///  cells changed since the last published generation, NULL if unknown
+///
+/// Viewers are only accepted by `stream_accept`
+void stream_publish(struct stream_server *server, struct board *board,
+                    const struct flip_set *flips) {
+  queue_frames(server, board, flips, false);
+  stream_flush(server);
+}
+
+/// Between generations, send a keyframe of the current one to every stale
+///  viewer which has caught up, e.g. one which has only just connected
+void stream_catch_up(struct stream_server *server, struct board *board) {
+  queue_frames(server, board, NULL, true);
+  stream_flush(server);
+}
+
+void stream_close(struct stream_server *server) {
+  while (server->n_clients) {
+    drop_client(server, 0);
+  }
+  free(server->clients);
+  if (server->fd != -1) {
+    close(server->fd);
+  }
+  if (server->path[0]) {
+    unlink(server->path);
+  }
+  memset(server, 0, sizeof(struct stream_server));
+  server->fd = -1;
+}
+
+/// Connect to a stream published on `addr`, the socket is non-blocking
+///  - E_OPTION if `addr` is not a valid address, E_IO with `errno` set if it
+///    cannot be connected to
+enum error_codes stream_connect(const char *addr, int *fd) {
+  struct sockaddr_storage sa;
+  socklen_t sa_len;
+  if (parse_addr(addr, &sa, &sa_len) != E_SUCCESS) {
+    return E_OPTION;
+  }
+  *fd = socket(sa.ss_family, SOCK_STREAM, 0);
+  if (*fd == -1) {
+    return E_IO;
+  }
+  if (connect(*fd, (struct sockaddr *)&sa, sa_len) == -1) {
+    int err = errno;
+    close(*fd);
+    errno = err;
+    return E_IO;
+  }
+  set_nonblocking(*fd);
+  return E_SUCCESS;
+}
+
+/// Apply a complete frame to the board, a keyframe of other dimensions
+///  replacing the board with one of its own
+static enum error_codes apply_frame(struct stream_reader *reader,
+                                    struct board *board) {
+  int lines = get_le(reader->header + 4, 4);
+  int cols = get_le(reader->header + 8, 4);
+  if (lines <= 0 || cols <= 0) {
+    return E_IO;
+  }
+  size_t keyframe_len = (((size_t)lines * cols) + 7) / 8;
+
+  if (reader->header[2] == FRAME_KEYFRAME) {
+    if (reader->len != keyframe_len) {
+      return E_IO;
+    }
+    if (board->lines != lines || board->cols != cols || !board->cells) {
+      board_free(board);
+      enum error_codes ec = board_init(board, lines, cols, false, NULL);
+      if (ec != E_SUCCESS) {
+        return ec;
+      }
+    }
+    apply_keyframe(board, reader->payload);
+  } else if (reader->header[2] == FRAME_DELTA) {
+    // A delta is only meaningful on top of the frames before it
+    if (!board->cells || board->lines != lines || board->cols != cols) {
+      return E_IO;
+    }
+    if (apply_delta(board, reader->payload, reader->len) != E_SUCCESS) {
+      return E_IO;
+    }
+  } else {
+    return E_IO;
+  }
+  board->generation = get_le(reader->header + 12, 8);
+  return E_SUCCESS;
+}
+
+/// Read whatever the stream has available without blocking, applying each
+///  complete frame to the board
+///  - `frames` is set to the number of frames applied
+///  - `board` must be zeroed or initialised before the first read
+enum error_codes stream_read(struct stream_reader *reader, int fd,
+                             struct board *board, int *frames) {
+  *frames = 0;
+  for (;;) {
+    uint8_t *dst;
+    size_t want;
+    if (reader->got < FRAME_HEADER_LEN) {
+      dst = reader->header + reader->got;
+      want = FRAME_HEADER_LEN - reader->got;
+    } else {
+      dst = reader->payload + (reader->got - FRAME_HEADER_LEN);
+      want = FRAME_HEADER_LEN + reader->len - reader->got;
+    }
+
+    if (want) {
+      ssize_t n = recv(fd, dst, want, 0);
+      if (n == 0) {
+        return E_IO;
+      }
+      if (n == -1) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR
+                   ? E_SUCCESS
+                   : E_IO;
+      }
+      reader->got += n;
+    }
+
+    if (reader->got == FRAME_HEADER_LEN && want) {
+      if (memcmp(reader->header, FRAME_MAGIC, sizeof(FRAME_MAGIC))) {
+        return E_IO;
+      }
+      reader->len = get_le(reader->header + 20, 8);
+      if (reader->len > reader->cap) {
+        uint8_t *payload = realloc(reader->payload, reader->len);
+        if (!payload) {
+          return E_ALLOC;
+        }
+        reader->payload = payload;
+        reader->cap = reader->len;
+      }
+    }
+
+    if (reader->got >= FRAME_HEADER_LEN &&
+        reader->got == FRAME_HEADER_LEN + reader->len) {
+      enum error_codes ec = apply_frame(reader, board);
+      if (ec != E_SUCCESS) {
+        return ec;
+      }
+      reader->got = 0;
+      (*frames)++;
+    }
+  }
+}
+
+void stream_reader_free(struct stream_reader *reader) {
+  free(reader->payload);
+  memset(reader, 0, sizeof(struct stream_reader));
+}
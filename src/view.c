@@ -0,0 +1,162 @@
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "golc.h"
+
+/// Sleep in microseconds between loops
+#define REFRESH_RATE_US 1000
+
+/// Buf size max for bottom-line message
+#define MSG_BUF_LEN 512
+
+static void show_view_help() {
+  fprintf(stderr,
+          "golc-view - Watch a golc run published with --serve\n"
+          "\n"
+          "    golc-view [--render block|half|braille] <socket>|<port>\n"
+          "\n"
+          "-h|--help)     Show this help message\n"
+          "--render)      Cells per character, block (1x1), half (1x2) or\n"
+          "               braille (2x4)\n");
+}
+
+/// Parse the viewer's arguments, only the render mode applies to it
+static enum error_codes parse_view_args(int argc, char **argv,
+                                        struct parsed_args *args,
+                                        char **addr) {
+  set_defaults(args);
+  *addr = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    char *opt = argv[i];
+    if (nstrcmp(opt, 2, "-h", "--help")) {
+      args->help = true;
+      return E_SUCCESS;
+
+    } else if (nstrcmp(opt, 1, "--render")) {
+      if (++i == argc) {
+        fprintf(stderr, "[CLI] Option (%s) has no string\n", opt);
+        return E_OPTION;
+      }
+      bool found = false;
+      for (int mode = 0; mode < RENDER_MODES; mode++) {
+        if (nstrcmp(argv[i], 1, (char *)RENDER_MODE_NAMES[mode])) {
+          args->render_mode = mode;
+          found = true;
+        }
+      }
+      if (!found) {
+        fprintf(stderr, "Unknown render mode (%s)\n", argv[i]);
+        return E_OPTION;
+      }
+
+    } else if (!*addr) {
+      *addr = opt;
+
+    } else {
+      fprintf(stderr, "Not an option (%s)\n", opt);
+      return E_OPTION;
+    }
+  }
+
+  if (!*addr) {
+    fprintf(stderr, "No stream address given\n");
+    return E_OPTION;
+  }
+  return E_SUCCESS;
+}
+
+/// Main curses loop, applying frames as they arrive and redrawing the board
+///  for each batch of them
+///
+/// Only the view can be changed, the board belongs to the server
+static enum error_codes view_loop(struct parsed_args *args, int fd,
+                                  const char *addr) {
+  enum error_codes ec = E_SUCCESS;
+  struct board board = {.cells = NULL};
+  struct stream_reader reader = {.payload = NULL};
+
+  char msg_buf[MSG_BUF_LEN];
+  snprintf(msg_buf, MSG_BUF_LEN, "Waiting for a frame from '%s'...", addr);
+
+  for (;;) {
+    int c = wgetch(stdscr);
+
+    /// 'q' is our 'quit' character breaking the for{}
+    if (c == 'q') {
+      break;
+    }
+
+    if (c != ERR && board.cells &&
+        !view_key(&board, args, c, msg_buf, MSG_BUF_LEN)) {
+      snprintf(msg_buf, MSG_BUF_LEN, "Unknown key '%s' (%d)", keyname(c), c);
+    }
+
+    int frames;
+    ec = stream_read(&reader, fd, &board, &frames);
+    if (ec != E_SUCCESS) {
+      break;
+    }
+    if (frames) {
+      draw_full_scr(&board, args);
+      uint64_t pop =
+          tile_range_pop(&board, 0, board.tile_lines, 0, board.tile_cols);
+      snprintf(msg_buf, MSG_BUF_LEN,
+               "Generation %ld, %lu active cells of [%d, %d]",
+               board.generation, pop, board.lines, board.cols);
+    }
+
+    draw_msg_buf(msg_buf);
+
+    // Sleep for a short period to avoid CPU overuse
+    usleep(REFRESH_RATE_US);
+  }
+
+  stream_reader_free(&reader);
+  board_free(&board);
+
+  return ec;
+}
+
+/// Entry-point
+///  - Connect to the stream
+///  - Render frames until the stream ends or 'q' is pressed
+int main(int argc, char **argv) {
+  struct parsed_args args;
+  char *addr;
+  if (parse_view_args(argc, argv, &args, &addr) != E_SUCCESS) {
+    show_view_help();
+    return E_OPTION;
+  }
+  if (args.help) {
+    show_view_help();
+    return E_SUCCESS;
+  }
+
+  int fd;
+  enum error_codes ec = stream_connect(addr, &fd);
+  if (ec == E_OPTION) {
+    fprintf(stderr, "Invalid stream address (%s)\n", addr);
+    return ec;
+  } else if (ec != E_SUCCESS) {
+    fprintf(stderr, "Could not connect to '%s' (%d)\n", addr, errno);
+    return ec;
+  }
+
+  if (init_screen() == E_CURSES) {
+    fprintf(stderr, "Error when initializing screen\n");
+    close(fd);
+    return E_CURSES;
+  }
+
+  ec = view_loop(&args, fd, addr);
+
+  endwin();
+  close(fd);
+
+  if (ec != E_SUCCESS) {
+    fprintf(stderr, "Stream from '%s' ended\n", addr);
+  }
+
+  return ec;
+}